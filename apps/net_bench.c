@@ -0,0 +1,465 @@
+/*
+ * Loopback network benchmark
+ *
+ * A server runs one thread per connection, which either echoes back what it
+ * reads, or answers each HTTP/1.1 request with the same small response. A load
+ * generator, with a scheduler of its own on another kernel thread, opens a
+ * number of connections to it over 127.0.0.1, each with a thread that sends a
+ * request and waits for the whole response, in a loop. For each number of
+ * connections, it reports requests per second and latency percentiles:
+ *
+ * echo 100 conns: 123456 req/s, p50 45 us, p90 60 us, p99 120 us, p99.9 300 us, 0 errors
+ *
+ * Usage: net_bench.x [echo|http] [connections,...] [seconds]
+ *
+ * By default, echo over 10, 100 and 1000 connections, for 1 second each. Each
+ * connection takes two file descriptors, counts the open files limit doesn't
+ * allow are skipped. Connections come from many loopback addresses, so that
+ * counts up to 100000 don't run out of ephemeral ports.
+ */
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <io.h>
+#include <sem.h>
+#include <uthread.h>
+
+/* Size of echo messages, and of connection buffers */
+#define ECHO_SIZE 64
+#define BUFFER_SIZE 4096
+
+/* Latencies are counted per microsecond up to this one, and beyond as one */
+#define HIST_US 1000000
+
+/* Loopback addresses connections come from, 127.0.0.2 onward */
+#define SOURCES 250
+
+/* File descriptors needed besides connections */
+#define FDS_SPARE 64
+
+static const char httpRequest[] = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+static const char httpResponse[] = "HTTP/1.1 200 OK\r\n"
+				   "Content-Type: text/plain\r\n"
+				   "Content-Length: 13\r\n"
+				   "\r\n"
+				   "Hello, world!";
+
+static bool http;
+
+static int listenFd = -1;
+static atomic_int serverPort;
+
+/* Load generator's state, only used by its own scheduler */
+struct bench {
+	int conns;
+	uint64_t duration;
+	uint64_t deadline;
+	sem_t connected;
+	sem_t go;
+	unsigned long requests;
+	unsigned long errors;
+	uint32_t *hist;
+	unsigned long slow;
+};
+
+/* Benchmark being run, one at a time */
+static struct bench *bench;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * write_all - Write a whole buffer to a connection
+ *
+ * Return: 0 in case of success, -1 otherwise
+ */
+static int write_all(int fd, const char *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t ret = uthread_write(fd, buf, len);
+
+		if (ret <= 0) {
+			return -1;
+		}
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+/*
+ * read_all - Read a whole buffer from a connection
+ *
+ * Return: 0 in case of success, -1 otherwise
+ */
+static int read_all(int fd, char *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t ret = uthread_read(fd, buf, len);
+
+		if (ret <= 0) {
+			return -1;
+		}
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static void server_echo(int fd)
+{
+	char buf[BUFFER_SIZE];
+	ssize_t len;
+
+	while ((len = uthread_read(fd, buf, sizeof(buf))) > 0) {
+		if (write_all(fd, buf, len)) {
+			break;
+		}
+	}
+}
+
+static void server_http(int fd)
+{
+	char buf[BUFFER_SIZE];
+	size_t len = 0;
+
+	for (;;) {
+		// Answer every complete request, keeping the connection alive
+		char *end;
+
+		while ((end = memmem(buf, len, "\r\n\r\n", 4)) != NULL) {
+			size_t used = end + 4 - buf;
+
+			if (write_all(fd, httpResponse, sizeof(httpResponse) - 1)) {
+				return;
+			}
+			memmove(buf, buf + used, len - used);
+			len -= used;
+		}
+
+		if (len == sizeof(buf)) {
+			return;
+		}
+
+		ssize_t ret = uthread_read(fd, buf + len, sizeof(buf) - len);
+		if (ret <= 0) {
+			return;
+		}
+		len += ret;
+	}
+}
+
+static void server_conn(void *arg)
+{
+	int fd = (intptr_t)arg;
+
+	if (http) {
+		server_http(fd);
+	} else {
+		server_echo(fd);
+	}
+	close(fd);
+}
+
+static void server_start(void *arg)
+{
+	(void)arg;
+
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	int one = 1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(listenFd, SOMAXCONN) ||
+	    getsockname(listenFd, (struct sockaddr *)&addr, &len)) {
+		perror("server");
+		atomic_store(&serverPort, -1);
+		return;
+	}
+	atomic_store(&serverPort, ntohs(addr.sin_port));
+
+	// Until the listening socket is shut down
+	for (;;) {
+		int fd = uthread_accept(listenFd, NULL, NULL);
+
+		if (fd < 0) {
+			if (errno == EMFILE || errno == ENFILE || errno == ECONNABORTED) {
+				continue;
+			}
+			break;
+		}
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		if (uthread_create(server_conn, (void *)(intptr_t)fd)) {
+			close(fd);
+		}
+	}
+}
+
+static void *server_main(void *arg)
+{
+	(void)arg;
+	uthread_run(false, server_start, NULL);
+
+	return NULL;
+}
+
+/*
+ * client_connect - Open a connection to the server
+ *
+ * Return: Socket of the connection, or -1 in case of failure
+ */
+static int client_connect(int id)
+{
+	struct sockaddr_in addr;
+	int one = 1;
+
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	// Source port is only picked on connect, per source and destination
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + id % SOURCES);
+	setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		close(fd);
+		return -1;
+	}
+
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(atomic_load(&serverPort));
+	if (uthread_connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/*
+ * client_request - Send a request and wait for its whole response
+ *
+ * Return: 0 in case of success, -1 otherwise
+ */
+static int client_request(int fd)
+{
+	char buf[sizeof(httpResponse)];
+
+	if (http) {
+		return write_all(fd, httpRequest, sizeof(httpRequest) - 1) ||
+		       read_all(fd, buf, sizeof(httpResponse) - 1);
+	}
+
+	memset(buf, 'x', ECHO_SIZE);
+	return write_all(fd, buf, ECHO_SIZE) || read_all(fd, buf, ECHO_SIZE);
+}
+
+static void client(void *arg)
+{
+	int fd = client_connect((intptr_t)arg);
+
+	if (fd < 0) {
+		bench->errors++;
+	}
+
+	// Everybody starts at once, after all connections are made
+	sem_up(bench->connected);
+	sem_down(bench->go);
+
+	if (fd < 0) {
+		return;
+	}
+
+	for (;;) {
+		uint64_t start = now_ns();
+
+		if (start >= bench->deadline) {
+			break;
+		}
+		if (client_request(fd)) {
+			bench->errors++;
+			break;
+		}
+
+		uint64_t us = (now_ns() - start) / 1000;
+		if (us < HIST_US) {
+			bench->hist[us]++;
+		} else {
+			bench->slow++;
+		}
+		bench->requests++;
+	}
+
+	close(fd);
+}
+
+static void client_start(void *arg)
+{
+	(void)arg;
+
+	for (int i = 0; i < bench->conns; i++) {
+		if (uthread_create(client, (void *)(intptr_t)i)) {
+			bench->errors++;
+			sem_up(bench->connected);
+		}
+	}
+
+	for (int i = 0; i < bench->conns; i++) {
+		sem_down(bench->connected);
+	}
+
+	bench->deadline = now_ns() + bench->duration;
+	for (int i = 0; i < bench->conns; i++) {
+		sem_up(bench->go);
+	}
+}
+
+/*
+ * percentile - Latency under which a share of the requests completed
+ * @permille: Share of the requests, in thousandths
+ *
+ * Return: Latency in microseconds, HIST_US if beyond what is counted
+ */
+static unsigned long percentile(unsigned int permille)
+{
+	unsigned long target = (bench->requests * permille + 999) / 1000;
+	unsigned long seen = 0;
+
+	for (unsigned long us = 0; us < HIST_US; us++) {
+		seen += bench->hist[us];
+		if (seen >= target) {
+			return us;
+		}
+	}
+
+	return HIST_US;
+}
+
+static void *client_main(void *arg)
+{
+	(void)arg;
+	uthread_run(false, client_start, NULL);
+
+	return NULL;
+}
+
+static void bench_run(int conns, double seconds)
+{
+	struct bench run;
+	pthread_t thread;
+
+	memset(&run, 0, sizeof(run));
+	run.conns = conns;
+	run.duration = seconds * 1e9;
+	run.connected = sem_create(0);
+	run.go = sem_create(0);
+	run.hist = calloc(HIST_US, sizeof(uint32_t));
+	bench = &run;
+
+	pthread_create(&thread, NULL, client_main, NULL);
+	pthread_join(thread, NULL);
+
+	printf("%s %d conns: %.0f req/s, p50 %lu us, p90 %lu us, p99 %lu us, "
+	       "p99.9 %lu us, %lu errors\n", http ? "http" : "echo", conns,
+	       run.requests / seconds, percentile(500), percentile(900),
+	       percentile(990), percentile(999), run.errors);
+
+	sem_destroy(run.connected);
+	sem_destroy(run.go);
+	free(run.hist);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *counts = "10,100,1000";
+	double seconds = 1;
+
+	if (argc > 1) {
+		http = strcmp(argv[1], "http") == 0;
+	}
+	if (argc > 2) {
+		counts = argv[2];
+	}
+	if (argc > 3) {
+		seconds = atof(argv[3]);
+	}
+
+	// As many connections as the system lets us
+	struct rlimit limit;
+
+	getrlimit(RLIMIT_NOFILE, &limit);
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+
+	pthread_t server;
+
+	pthread_create(&server, NULL, server_main, NULL);
+	while (atomic_load(&serverPort) == 0) {
+		usleep(1000);
+	}
+	if (atomic_load(&serverPort) < 0) {
+		pthread_join(server, NULL);
+		return 1;
+	}
+
+	for (const char *p = counts; *p != '\0';) {
+		char *end;
+		long conns = strtol(p, &end, 10);
+
+		if (end == p) {
+			break;
+		}
+		p = *end == ',' ? end + 1 : end;
+
+		if (conns <= 0) {
+			continue;
+		}
+		if ((rlim_t)conns * 2 + FDS_SPARE > limit.rlim_cur) {
+			printf("%s %ld conns: skipped, open files limited to %lu\n",
+			       http ? "http" : "echo", conns,
+			       (unsigned long)limit.rlim_cur);
+			continue;
+		}
+
+		bench_run(conns, seconds);
+	}
+
+	// Server's threads are all done once its listening socket is shut down
+	shutdown(listenFd, SHUT_RDWR);
+	pthread_join(server, NULL);
+	close(listenFd);
+
+	return 0;
+}
@@ -90,6 +90,125 @@ void test_delete() {
 	TEST_ASSERT(queue_length(q) == 0);
 }
 
+void test_delete_last() {
+	int a, b, c;
+	void* data;
+
+	queue_enqueue(q, &a);
+	queue_enqueue(q, &b);
+	queue_enqueue(q, &c); // q = &a, &b, &c
+
+	// Deleting the back leaves the queue appending after the new back
+	queue_delete(q, &b); // q = &a, &c
+	queue_delete(q, &c); // q = &a
+	queue_enqueue(q, &b); // q = &a, &b
+	queue_dequeue(q, &data);
+	TEST_ASSERT(data == &a);
+	queue_dequeue(q, &data);
+	TEST_ASSERT(data == &b);
+	TEST_ASSERT(queue_length(q) == 0);
+}
+
+void test_remove_handle() {
+	int a, b, c;
+	queue_handle_t ha, hb, hc;
+	void* data;
+
+	queue_enqueue_handle(q, &a, &ha);
+	queue_enqueue_handle(q, &b, &hb);
+	queue_enqueue_handle(q, &c, &hc); // q = &a, &b, &c
+
+	TEST_ASSERT(queue_remove_handle(q, hb) == 0); // q = &a, &c
+	TEST_ASSERT(queue_length(q) == 2);
+	queue_remove_handle(q, hc); // q = &a
+	queue_enqueue_handle(q, &b, &hb); // q = &a, &b
+	queue_remove_handle(q, ha); // q = &b
+	queue_enqueue(q, &c); // q = &b, &c
+	queue_dequeue(q, &data);
+	TEST_ASSERT(data == &b);
+	queue_dequeue(q, &data);
+	TEST_ASSERT(data == &c);
+
+	// Many items removed from the middle, in any order
+	int items[1000];
+	queue_handle_t handles[1000];
+	for (int i = 0; i < 1000; i++) {
+		queue_enqueue_handle(q, items + i, handles + i);
+	}
+	for (int i = 1; i < 1000; i += 2) {
+		queue_remove_handle(q, handles[i]);
+	}
+	TEST_ASSERT(queue_length(q) == 500);
+	bool ordered = true;
+	for (int i = 0; i < 1000; i += 2) {
+		queue_dequeue(q, &data);
+		ordered = ordered && data == items + i;
+	}
+	TEST_ASSERT(ordered);
+	TEST_ASSERT(queue_length(q) == 0);
+}
+
+void test_bulk() {
+	int items[10];
+	void* data[10];
+
+	for (int i = 0; i < 10; i++) {
+		data[i] = items + i;
+	}
+	TEST_ASSERT(queue_enqueue_bulk(q, data, 4) == 0); // q = 0..3
+	queue_enqueue(q, items + 4); // q = 0..4
+	TEST_ASSERT(queue_enqueue_bulk(q, data + 5, 5) == 0); // q = 0..9
+	TEST_ASSERT(queue_length(q) == 10);
+
+	// NULL item, nothing enqueued
+	data[7] = NULL;
+	TEST_ASSERT(queue_enqueue_bulk(q, data, 10) == -1);
+	TEST_ASSERT(queue_length(q) == 10);
+
+	void* out[10];
+	TEST_ASSERT(queue_dequeue_bulk(q, out, 3) == 3);
+	TEST_ASSERT(out[0] == items && out[2] == items + 2);
+	TEST_ASSERT(queue_dequeue_bulk(q, out, 10) == 7);
+	TEST_ASSERT(out[0] == items + 3 && out[6] == items + 9);
+	TEST_ASSERT(queue_dequeue_bulk(q, out, 10) == 0);
+	TEST_ASSERT(queue_length(q) == 0);
+}
+
+void test_splice() {
+	int a, b, c, d;
+	queue_t other = queue_create();
+	queue_handle_t hc;
+	void* data;
+
+	queue_enqueue(q, &a);
+	queue_enqueue(q, &b);
+	queue_enqueue(other, &c);
+	queue_enqueue_handle(other, &d, &hc);
+	queue_enqueue(other, &c); // q = &a, &b, other = &c, &d, &c
+
+	TEST_ASSERT(queue_splice(q, other) == 0); // q = &a, &b, &c, &d, &c
+	TEST_ASSERT(queue_length(q) == 5);
+	TEST_ASSERT(queue_length(other) == 0);
+
+	// Handle moved along with its item
+	queue_remove_handle(q, hc); // q = &a, &b, &c, &c
+	queue_dequeue(q, &data);
+	TEST_ASSERT(data == &a);
+
+	// Into an empty queue, and back
+	TEST_ASSERT(queue_splice(other, q) == 0); // other = &b, &c, &c
+	TEST_ASSERT(queue_splice(q, other) == 0); // q = &b, &c, &c
+	TEST_ASSERT(queue_splice(q, other) == 0);
+	TEST_ASSERT(queue_length(q) == 3);
+	queue_dequeue(q, &data);
+	TEST_ASSERT(data == &b);
+	queue_dequeue(q, &data);
+	queue_dequeue(q, &data);
+	TEST_ASSERT(data == &c);
+
+	queue_destroy(other);
+}
+
 static void increment(queue_t q, void *data) {
     int* i = (int*) data;
 	if (*i >= 0) {
@@ -130,6 +249,11 @@ void test_edge_cases() {
 	TEST_ASSERT(queue_dequeue(q, data) == -1);
 	TEST_ASSERT(queue_delete(q, data) == -1);
 	TEST_ASSERT(queue_iterate(q, function) == -1);
+	TEST_ASSERT(queue_enqueue_handle(q, data, data) == -1);
+	TEST_ASSERT(queue_remove_handle(q, data) == -1);
+	TEST_ASSERT(queue_enqueue_bulk(q, data, 1) == -1);
+	TEST_ASSERT(queue_dequeue_bulk(q, data, 1) == -1);
+	TEST_ASSERT(queue_splice(q, q) == -1);
 
 	// data is null
 	q = queue_create();
@@ -137,16 +261,21 @@ void test_edge_cases() {
 	TEST_ASSERT(queue_enqueue(q, data) == -1);
 	TEST_ASSERT(queue_dequeue(q, data) == -1);
 	TEST_ASSERT(queue_delete(q, data) == -1);
+	TEST_ASSERT(queue_remove_handle(q, data) == -1);
+	TEST_ASSERT(queue_enqueue_bulk(q, data, 1) == -1);
+	TEST_ASSERT(queue_dequeue_bulk(q, data, 1) == -1);
+	TEST_ASSERT(queue_splice(q, q) == -1);
 
 	// function is null
 	function = NULL;
 	TEST_ASSERT(queue_iterate(q, function) == -1);
 
 	// queue is empty
+	int a;
 	TEST_ASSERT(queue_dequeue(q, data) == -1);
+	TEST_ASSERT(queue_delete(q, &a) == -1);
 
 	// queue is not empty
-	int a;
 	queue_enqueue(q, &a);
 	TEST_ASSERT(queue_destroy(q) == -1);
 
@@ -158,10 +287,10 @@ void test_edge_cases() {
 	queue_destroy(q);
 }
 
-# define NUM_TESTS 5
+# define NUM_TESTS 9
 # define NUM_TRIALS 2 
-char* tests[NUM_TESTS] = {"create", "enqueue", "length", "delete", "iterate"};
-function_t testFunction[NUM_TESTS] = {&test_create, &test_enqueue, &test_length, &test_delete, &test_iterate};
+char* tests[NUM_TESTS] = {"create", "enqueue", "length", "delete", "delete_last", "remove_handle", "bulk", "splice", "iterate"};
+function_t testFunction[NUM_TESTS] = {&test_create, &test_enqueue, &test_length, &test_delete, &test_delete_last, &test_remove_handle, &test_bulk, &test_splice, &test_iterate};
 /// have all test cases run through at least 2 iterations of action/inverse
 /// and have one with all errors/edge cases
 
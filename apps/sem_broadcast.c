@@ -0,0 +1,75 @@
+/*
+ * Semaphore broadcast test
+ *
+ * Many threads wait on the same semaphore, and are all woken up by a single
+ * broadcast, after which they wait on it again until a second broadcast. The
+ * count of the semaphore doesn't change. The program should output:
+ *
+ * round 1: 1000 threads woken
+ * round 2: 1000 threads woken
+ * count: 0, destroyed
+ */
+
+#include <stdio.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define THREADS 1000
+
+static sem_t gate;
+static int woken[2];
+static int probed;
+
+static void waiter(void *arg)
+{
+	(void)arg;
+
+	for (int round = 0; round < 2; round++) {
+		sem_down(gate);
+		woken[round]++;
+	}
+}
+
+static void probe(void *arg)
+{
+	(void)arg;
+
+	sem_down(gate);
+	probed++;
+}
+
+static void start(void *arg)
+{
+	(void)arg;
+
+	for (int i = 0; i < THREADS; i++) {
+		uthread_create(waiter, NULL);
+	}
+
+	// Waiters all block, then run once everybody is woken up
+	for (int round = 0; round < 2; round++) {
+		uthread_yield();
+		sem_broadcast(gate);
+		uthread_yield();
+		printf("round %d: %d threads woken\n", round + 1, woken[round]);
+	}
+
+	// No resource is left over, a new waiter only gets the one given
+	uthread_create(probe, NULL);
+	uthread_yield();
+	printf("count: %d, ", probed);
+	sem_up(gate);
+}
+
+int main(void)
+{
+	gate = sem_create(0);
+
+	uthread_run(false, start, NULL);
+
+	printf("%s\n", probed == 1 && sem_destroy(gate) == 0 ?
+	       "destroyed" : "FAIL");
+
+	return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Adaptive time slice test
+ *
+ * Runs a thread that yields right after a bit of work alongside a thread that
+ * never yields, with adaptive time slices enabled. The first one should end up
+ * with time slices shorter than the default, and the second one with longer
+ * time slices. The program should output:
+ *
+ * interactive quantum: shorter
+ * cpu-bound quantum: longer
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+#define QUANTUM 2000
+#define ROUNDS 20
+
+static volatile bool done;
+static uthread_t interactive, cpuBound;
+
+static const char *compare(uthread_t thread)
+{
+	struct uthread_stats stats;
+
+	uthread_stats(thread, &stats);
+	if (stats.quantum < QUANTUM) {
+		return "shorter";
+	}
+	if (stats.quantum > QUANTUM) {
+		return "longer";
+	}
+
+	return "default";
+}
+
+static void spin(unsigned long loops)
+{
+	for (volatile unsigned long i = 0; i < loops; i++);
+}
+
+static void thread_interactive(void *arg)
+{
+	(void)arg;
+
+	for (int i = 0; i < ROUNDS; i++) {
+		spin(1000);
+		uthread_yield();
+	}
+
+	printf("interactive quantum: %s\n", compare(interactive));
+	printf("cpu-bound quantum: %s\n", compare(cpuBound));
+	done = true;
+}
+
+static void thread_cpu(void *arg)
+{
+	(void)arg;
+
+	while (!done) {
+		spin(1000);
+	}
+}
+
+static void thread0(void *arg)
+{
+	(void)arg;
+
+	uthread_create_handle(thread_interactive, NULL, &interactive);
+	uthread_create_handle(thread_cpu, NULL, &cpuBound);
+}
+
+int main(void)
+{
+	struct uthread_config config;
+
+	uthread_config_init(&config);
+	config.preempt = true;
+	config.quantum = QUANTUM;
+	config.adaptive = true;
+
+	return uthread_run_config(&config, thread0, NULL) == 0 ? EXIT_SUCCESS :
+		EXIT_FAILURE;
+}
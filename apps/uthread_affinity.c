@@ -0,0 +1,68 @@
+/*
+ * Placement test
+ *
+ * Runs the threads pinned to the first CPU, with memory from the first NUMA
+ * node, including a thread created with a placement hint. Invalid placements
+ * are rejected, and the original placement comes back once done. The program
+ * should output:
+ *
+ * pinned: 1 cpu
+ * node: thread ran
+ * invalid: rejected
+ * restored: ok
+ */
+
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+static void hinted(void *arg)
+{
+	(void)arg;
+	printf("node: thread ran\n");
+}
+
+static void test(void *arg)
+{
+	(void)arg;
+	cpu_set_t cpus;
+
+	sched_getaffinity(0, sizeof(cpus), &cpus);
+	printf("pinned: %d cpu\n", CPU_COUNT(&cpus));
+
+	uthread_create_node(hinted, NULL, 0, NULL);
+}
+
+static void nothing(void *arg)
+{
+	(void)arg;
+}
+
+int main(void)
+{
+	struct uthread_config config;
+	cpu_set_t before, after;
+
+	sched_getaffinity(0, sizeof(before), &before);
+
+	uthread_config_init(&config);
+	config.cpus = "0";
+	config.numa_node = 0;
+	uthread_run_config(&config, test, NULL);
+
+	uthread_config_init(&config);
+	config.cpus = "1-0";
+	int badCpus = uthread_run_config(&config, nothing, NULL);
+	config.cpus = NULL;
+	config.numa_node = 4096;
+	int badNode = uthread_run_config(&config, nothing, NULL);
+	printf("invalid: %s\n", badCpus == -1 && badNode == -1 ? "rejected" : "FAIL");
+
+	sched_getaffinity(0, sizeof(after), &after);
+	printf("restored: %s\n", CPU_EQUAL(&before, &after) ? "ok" : "FAIL");
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * Thread arena test
+ *
+ * Many threads make small allocations of various sizes, and a large one, which
+ * must all be aligned and not overlap. The memory of a thread that exited is
+ * reused by the next one, and nothing can be allocated outside of the library.
+ * The program should output:
+ *
+ * threads: 1000 threads, allocations ok
+ * recycled: chunk reused
+ * outside: NULL
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <uthread.h>
+
+#define THREADS 1000
+#define ALLOCS 200
+#define LARGE 65536
+
+static bool ok = true;
+static int finished;
+static void *first;
+static void *second;
+
+static void worker(void *arg)
+{
+	intptr_t id = (intptr_t)arg;
+	unsigned char *blocks[ALLOCS];
+	size_t sizes[ALLOCS];
+
+	for (int i = 0; i < ALLOCS; i++) {
+		sizes[i] = 1 + (id * 7 + i * 13) % 300;
+		blocks[i] = uthread_alloc(sizes[i]);
+		if (blocks[i] == NULL ||
+		    (uintptr_t)blocks[i] % _Alignof(max_align_t) != 0) {
+			ok = false;
+			return;
+		}
+		memset(blocks[i], i & 0xff, sizes[i]);
+
+		// Other threads allocate meanwhile
+		if (i % 50 == 0) {
+			uthread_yield();
+		}
+	}
+
+	unsigned char *large = uthread_alloc(LARGE);
+	if (large == NULL) {
+		ok = false;
+		return;
+	}
+	memset(large, 0xaa, LARGE);
+
+	for (int i = 0; i < ALLOCS; i++) {
+		for (size_t j = 0; j < sizes[i]; j++) {
+			if (blocks[i][j] != (i & 0xff)) {
+				ok = false;
+			}
+		}
+	}
+	finished++;
+}
+
+static void reuser(void *arg)
+{
+	(void)arg;
+	second = uthread_alloc(1);
+}
+
+static void owner(void *arg)
+{
+	(void)arg;
+	first = uthread_alloc(1);
+
+	// Runs once this thread has exited
+	uthread_create(reuser, NULL);
+}
+
+static void start(void *arg)
+{
+	(void)arg;
+	for (intptr_t i = 0; i < THREADS; i++) {
+		uthread_create(worker, (void *)i);
+	}
+}
+
+int main(void)
+{
+	uthread_run(false, start, NULL);
+	printf("threads: %d threads, allocations %s\n", finished,
+	       ok && finished == THREADS ? "ok" : "FAIL");
+
+	uthread_run(false, owner, NULL);
+	printf("recycled: %s\n", first != NULL && first == second ?
+	       "chunk reused" : "FAIL");
+
+	printf("outside: %s\n", uthread_alloc(1) == NULL ? "NULL" : "FAIL");
+
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Batch creation test
+ *
+ * Creates many threads with a single call, checks that each one gets its own
+ * argument, and times creation against one call per thread. The program should
+ * output:
+ *
+ * batch: 10000 threads, sum ok
+ * single: 10000 threads, sum ok
+ *
+ * followed by the time taken by each.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <uthread.h>
+
+#define THREADS 10000
+
+static long sum;
+static double batchTime, singleTime;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void thread(void *arg)
+{
+	sum += (intptr_t)arg;
+}
+
+static void report(const char *name)
+{
+	long expected = (long)THREADS * (THREADS + 1) / 2;
+
+	printf("%s: %d threads, sum %s\n", name, THREADS,
+	       sum == expected ? "ok" : "FAIL");
+	sum = 0;
+}
+
+static void thread_batch(void *arg)
+{
+	void **args = malloc(THREADS * sizeof(void *));
+	uthread_t *handles = malloc(THREADS * sizeof(uthread_t));
+	(void)arg;
+
+	for (intptr_t i = 0; i < THREADS; i++) {
+		args[i] = (void *)(i + 1);
+	}
+
+	double start = now();
+	if (uthread_create_batch(THREADS, thread, args, handles) == -1) {
+		printf("batch: FAIL\n");
+	}
+	batchTime = now() - start;
+
+	if (handles[0] == NULL || handles[THREADS - 1] == NULL) {
+		printf("batch: FAIL\n");
+	}
+
+	free(args);
+	free(handles);
+}
+
+static void thread_single(void *arg)
+{
+	(void)arg;
+
+	double start = now();
+	for (intptr_t i = 0; i < THREADS; i++) {
+		if (uthread_create(thread, (void *)(i + 1)) == -1) {
+			printf("single: FAIL\n");
+		}
+	}
+	singleTime = now() - start;
+}
+
+int main(void)
+{
+	uthread_run(false, thread_batch, NULL);
+	report("batch");
+
+	uthread_run(false, thread_single, NULL);
+	report("single");
+
+	fprintf(stderr, "batch %.0f us, single %.0f us\n", batchTime, singleTime);
+
+	return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * Earliest deadline first policy test
+ *
+ * Threads created with deadlines in scrambled order run by deadline, before
+ * the threads without one. A thread woken up by a thread without a deadline
+ * runs right away. A ready thread given an earlier deadline than the one
+ * keeping the CPU busy takes over at the next tick, and so does a thread woken
+ * up from another kernel thread. Threads that are done before their deadline
+ * count as met, the others as missed. The program should output:
+ *
+ * order: 10 20 30 none main
+ * wake: woken thread first
+ * deadlines: 5 met, 2 missed, lateness ok
+ * self: 1 met, 1 missed
+ * tick: preempted
+ * remote: preempted
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <policy.h>
+#include <sem.h>
+#include <uthread.h>
+
+#define MS 1000000ULL
+
+static char order[64];
+
+static sem_t sem;
+static bool mainContinued;
+static bool wokeFirst;
+
+static uthread_t urgentHandle;
+static volatile bool urgentRan;
+static bool preempted;
+
+static atomic_bool parked;
+static _Atomic(uthread_t) remoteHandle;
+static bool remotePreempted;
+
+/*
+ * spin - Use up CPU time
+ */
+static void spin(long ms)
+{
+	struct timespec start, now;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+	do {
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	} while ((now.tv_sec - start.tv_sec) * 1000 +
+		 (now.tv_nsec - start.tv_nsec) / 1000000 < ms);
+}
+
+static void label(void *arg)
+{
+	strcat(order, " ");
+	strcat(order, arg);
+}
+
+static void waiter(void *arg)
+{
+	(void)arg;
+
+	sem_down(sem);
+	wokeFirst = !mainContinued;
+}
+
+static void late(void *arg)
+{
+	(void)arg;
+
+	spin(5);
+}
+
+static void thread0(void *arg)
+{
+	(void)arg;
+
+	// Run by deadline once main yields, then in creation order
+	uthread_create_deadline(label, "30", 30 * MS, NULL);
+	uthread_create_deadline(label, "10", 10 * MS, NULL);
+	uthread_create_deadline(label, "20", 20 * MS, NULL);
+	uthread_create(label, "none");
+	uthread_yield();
+	label("main");
+	printf("order:%s\n", order);
+
+	// Blocks, then preempts main as soon as it is woken up
+	sem = sem_create(0);
+	uthread_create_deadline(waiter, NULL, 50 * MS, NULL);
+	uthread_yield();
+	sem_up(sem);
+	mainContinued = true;
+	printf("wake: %s\n", wokeFirst ? "woken thread first" : "FAIL");
+	sem_destroy(sem);
+
+	// Missed, at least 4 ms late
+	uthread_create_deadline(late, NULL, 1 * MS, NULL);
+	uthread_yield();
+
+	// Missed by main itself, then met
+	uthread_t self = uthread_self();
+
+	uthread_set_deadline(self, 1 * MS);
+	spin(3);
+	uthread_set_deadline(self, 0);
+	uthread_set_deadline(self, 1000 * MS);
+	uthread_set_deadline(self, 0);
+
+	struct uthread_deadline_stats stats;
+
+	uthread_deadline_stats(NULL, &stats);
+	if (stats.met == 5 && stats.missed == 2 && stats.max_lateness >= 4 * MS) {
+		printf("deadlines: 5 met, 2 missed, lateness ok\n");
+	} else {
+		printf("deadlines: FAIL (%lu met, %lu missed, %lu ns late)\n",
+		       (unsigned long)stats.met, (unsigned long)stats.missed,
+		       (unsigned long)stats.max_lateness);
+	}
+
+	uthread_deadline_stats(self, &stats);
+	if (stats.met == 1 && stats.missed == 1) {
+		printf("self: 1 met, 1 missed\n");
+	} else {
+		printf("self: FAIL\n");
+	}
+}
+
+static void urgent(void *arg)
+{
+	(void)arg;
+
+	urgentRan = true;
+}
+
+static void background(void *arg)
+{
+	(void)arg;
+
+	// Ready thread becomes more urgent, but only the next tick notices
+	uthread_set_deadline(urgentHandle, 1000 * MS);
+
+	// Never gives up the CPU on its own
+	struct timespec start, now;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		if (urgentRan) {
+			preempted = true;
+			break;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	} while (now.tv_sec - start.tv_sec < 5);
+}
+
+static void tick0(void *arg)
+{
+	(void)arg;
+
+	// Background runs first, the other thread has no deadline yet
+	uthread_create_handle(urgent, NULL, &urgentHandle);
+	uthread_create_deadline(background, NULL, 10000 * MS, NULL);
+}
+
+static void remote(void *arg)
+{
+	(void)arg;
+
+	atomic_store(&parked, true);
+	uthread_park();
+	urgentRan = true;
+}
+
+static void remote_background(void *arg)
+{
+	(void)arg;
+
+	// Never gives up the CPU on its own
+	struct timespec start, now;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		if (urgentRan) {
+			remotePreempted = true;
+			break;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	} while (now.tv_sec - start.tv_sec < 5);
+}
+
+static void remote0(void *arg)
+{
+	(void)arg;
+
+	uthread_t handle;
+
+	// Remote thread parks first, then background runs
+	uthread_create_deadline(remote, NULL, 1000 * MS, &handle);
+	atomic_store(&remoteHandle, handle);
+	uthread_create_deadline(remote_background, NULL, 10000 * MS, NULL);
+}
+
+static void *waker(void *arg)
+{
+	(void)arg;
+
+	while (!atomic_load(&parked)) {
+		usleep(1000);
+	}
+	usleep(20000);
+	uthread_unpark(atomic_load(&remoteHandle));
+
+	return NULL;
+}
+
+int main(void)
+{
+	struct uthread_config config;
+
+	uthread_config_init(&config);
+	config.policy = &uthread_policy_edf;
+	uthread_run_config(&config, thread0, NULL);
+
+	config.preempt = true;
+	uthread_run_config(&config, tick0, NULL);
+	printf("tick: %s\n", preempted ? "preempted" : "FAIL");
+
+	pthread_t thread;
+
+	urgentRan = false;
+	pthread_create(&thread, NULL, waker, NULL);
+	uthread_run_config(&config, remote0, NULL);
+	pthread_join(thread, NULL);
+	printf("remote: %s\n", remotePreempted ? "preempted" : "FAIL");
+
+	return 0;
+}
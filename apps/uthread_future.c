@@ -0,0 +1,177 @@
+/*
+ * Futures test
+ *
+ * Fans requests out to asynchronous functions and waits for all of them, which
+ * should only block the caller once, then for the first one of a fast and a
+ * slow function. Also checks callbacks attached before and after a result is
+ * set, futures run in a thread pool, a future reused before the thread it woke
+ * up runs, and threads waiting on the shared stack. The program should output:
+ *
+ * all: sum ok, blocked 1 time
+ * any: first 1
+ * then: 2 callbacks
+ * pool: 1000 results, sum ok
+ * reused: first 0
+ * shared: 8 results ok
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <future.h>
+#include <pool.h>
+#include <uthread.h>
+
+#define FANOUT 8
+#define POOL_JOBS 1000
+#define SHARED 8
+
+static int callbacks;
+
+static uthread_future_t raced[2];
+static volatile bool quickDone;
+static volatile int racedFirst = -1;
+
+static int sharedOk;
+static int sharedDone;
+
+static void *square(void *arg)
+{
+	intptr_t n = (intptr_t)arg;
+
+	return (void *)(n * n);
+}
+
+static void *slow(void *arg)
+{
+	for (int i = 0; i < 10; i++) {
+		uthread_yield();
+	}
+	return arg;
+}
+
+static void *quick(void *arg)
+{
+	uthread_yield();
+	quickDone = true;
+	return arg;
+}
+
+static void racer(void *arg)
+{
+	(void)arg;
+	racedFirst = uthread_await_any(raced, 2);
+}
+
+static void shared_waiter(void *arg)
+{
+	void *result;
+	uthread_future_t future = uthread_async(slow, arg);
+
+	if (uthread_await(future, &result) == 0 && result == arg) {
+		sharedOk++;
+	}
+	uthread_future_destroy(future);
+	sharedDone++;
+}
+
+static void callback(void *result, void *arg)
+{
+	if (result == arg) {
+		callbacks++;
+	}
+}
+
+static void test(void *arg)
+{
+	(void)arg;
+	uthread_future_t futures[POOL_JOBS];
+	struct uthread_stats before, after;
+	intptr_t sum, expected;
+	void *result;
+
+	// Fan-out, results awaited at once
+	for (intptr_t i = 0; i < FANOUT; i++) {
+		futures[i] = uthread_async(square, (void *)i);
+	}
+	uthread_stats(uthread_self(), &before);
+	uthread_await_all(futures, FANOUT);
+	uthread_stats(uthread_self(), &after);
+
+	sum = expected = 0;
+	for (intptr_t i = 0; i < FANOUT; i++) {
+		uthread_await(futures[i], &result);
+		sum += (intptr_t)result;
+		expected += i * i;
+		uthread_future_destroy(futures[i]);
+	}
+	printf("all: sum %s, blocked %lu time\n", sum == expected ? "ok" : "FAIL",
+	       after.switches - before.switches);
+
+	// First result available
+	futures[0] = uthread_async(slow, NULL);
+	futures[1] = uthread_async(square, (void *)2);
+	printf("any: first %d\n", uthread_await_any(futures, 2));
+	uthread_future_destroy(futures[0]);
+	uthread_future_destroy(futures[1]);
+
+	// Callbacks, then future destroyed before its result is set
+	futures[0] = uthread_async(square, (void *)3);
+	uthread_future_then(futures[0], callback, (void *)9);
+	uthread_await(futures[0], NULL);
+	uthread_future_then(futures[0], callback, (void *)9);
+	uthread_future_destroy(futures[0]);
+	uthread_future_destroy(uthread_async(slow, NULL));
+	printf("then: %d callbacks\n", callbacks);
+
+	// Futures run by a pool
+	uthread_pool_t pool = uthread_pool_create(4);
+	for (intptr_t i = 0; i < POOL_JOBS; i++) {
+		futures[i] = uthread_pool_async(pool, square, (void *)i);
+	}
+	uthread_await_all(futures, POOL_JOBS);
+
+	sum = expected = 0;
+	for (intptr_t i = 0; i < POOL_JOBS; i++) {
+		uthread_await(futures[i], &result);
+		sum += (intptr_t)result;
+		expected += i * i;
+		uthread_future_destroy(futures[i]);
+	}
+	printf("pool: %d results, sum %s\n", POOL_JOBS, sum == expected ? "ok" : "FAIL");
+	uthread_pool_destroy(pool);
+
+	// Future set, destroyed and reused before the thread it woke up runs
+	raced[0] = uthread_async(quick, NULL);
+	raced[1] = uthread_async(slow, NULL);
+	uthread_create(racer, NULL);
+	while (!quickDone) {
+		uthread_yield();
+	}
+	uthread_future_destroy(raced[0]);
+	futures[0] = uthread_async(square, NULL);
+	while (racedFirst < 0) {
+		uthread_yield();
+	}
+	uthread_await(raced[1], NULL);
+	uthread_future_destroy(raced[1]);
+	uthread_future_destroy(futures[0]);
+	printf("reused: first %d\n", racedFirst);
+
+	// Waiting threads switched out of the shared stack
+	for (intptr_t i = 0; i < SHARED; i++) {
+		uthread_create_shared(shared_waiter, (void *)i, NULL);
+	}
+	while (sharedDone < SHARED) {
+		uthread_yield();
+	}
+	printf("shared: %d results %s\n", SHARED, sharedOk == SHARED ? "ok" : "FAIL");
+}
+
+int main(void)
+{
+	uthread_run(false, test, NULL);
+	return 0;
+}
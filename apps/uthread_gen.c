@@ -0,0 +1,88 @@
+/*
+ * Generator test
+ *
+ * Tests direct transfers between threads: a generator produces the first
+ * Fibonacci numbers for a consumer thread, while another thread shows that
+ * uthread_switch_to() skips over the rest of the ready queue. The program
+ * should output:
+ *
+ * 0 1 1 2 3 5 8 13
+ * done
+ * target
+ * other
+ * back
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <gen.h>
+#include <uthread.h>
+
+static void fibonacci(void *arg)
+{
+	intptr_t count = (intptr_t)arg;
+	intptr_t a = 0, b = 1;
+
+	for (intptr_t i = 0; i < count; i++) {
+		uthread_gen_yield((void *)a);
+		intptr_t next = a + b;
+		a = b;
+		b = next;
+	}
+}
+
+static void forever(void *arg)
+{
+	(void)arg;
+
+	for (intptr_t i = 0; ; i++) {
+		uthread_gen_yield((void *)i);
+	}
+}
+
+static void other(void *arg)
+{
+	(void)arg;
+	printf("other\n");
+}
+
+static void target(void *arg)
+{
+	(void)arg;
+	printf("target\n");
+}
+
+static void consumer(void *arg)
+{
+	(void)arg;
+	void *value;
+
+	uthread_gen_t gen = uthread_gen_create(fibonacci, (void *)8);
+	while (uthread_gen_next(gen, &value) == 0) {
+		printf("%ld ", (long)(intptr_t)value);
+	}
+	printf("\ndone\n");
+	uthread_gen_destroy(gen);
+
+	// Destroying an unfinished generator makes it exit
+	gen = uthread_gen_create(forever, NULL);
+	uthread_gen_next(gen, &value);
+	uthread_gen_next(gen, &value);
+	uthread_gen_destroy(gen);
+
+	uthread_t handle;
+	uthread_create(other, NULL);
+	uthread_create_handle(target, NULL, &handle);
+	uthread_switch_to(handle);
+	uthread_yield();
+	printf("back\n");
+}
+
+int main(void)
+{
+	uthread_run(false, consumer, NULL);
+	return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * Thread group test
+ *
+ * Under the fair-share policy, a group with a single thread competes with a
+ * group of 100 threads, all of them using as much CPU time as they can. CPU
+ * time is shared according to the weight of the groups, not to their number of
+ * threads: half of it goes to the single thread when the groups have the same
+ * weight, and three quarters once its group weighs three times more. The
+ * program should output:
+ *
+ * 1 vs 100 threads, weights 1:1: share ok
+ * 1 vs 100 threads, weights 3:1: share ok
+ * groups destroyed
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <policy.h>
+#include <uthread.h>
+
+#define THREADS 100
+
+/* Length of each run, in milliseconds */
+#define DURATION 300
+
+/* Error allowed on the share of the single thread, in percent */
+#define TOLERANCE 10
+
+static uthread_group_t one;
+static uthread_group_t many;
+static unsigned int weight;
+static struct timespec end;
+
+static bool expired(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec > end.tv_sec ||
+	       (now.tv_sec == end.tv_sec && now.tv_nsec >= end.tv_nsec);
+}
+
+static void spinner(void *arg)
+{
+	(void)arg;
+
+	// Never yields, only preemption switches threads
+	while (!expired()) {
+	}
+}
+
+static void thread0(void *arg)
+{
+	(void)arg;
+
+	one = uthread_group_create(UTHREAD_GROUP_WEIGHT_DEFAULT);
+	many = uthread_group_create(UTHREAD_GROUP_WEIGHT_DEFAULT);
+	uthread_group_set_weight(one, weight);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	end.tv_nsec += (DURATION % 1000) * 1000000L;
+	end.tv_sec += DURATION / 1000 + end.tv_nsec / 1000000000L;
+	end.tv_nsec %= 1000000000L;
+
+	// Threads join the group of the thread that creates them
+	uthread_t self = uthread_self();
+
+	uthread_group_join(self, one);
+	uthread_create(spinner, NULL);
+	uthread_group_join(self, many);
+	for (int i = 0; i < THREADS; i++) {
+		uthread_create(spinner, NULL);
+	}
+	uthread_group_join(self, NULL);
+}
+
+static bool run(unsigned int ratio)
+{
+	struct uthread_config config;
+
+	uthread_config_init(&config);
+	config.policy = &uthread_policy_fair;
+	config.preempt = true;
+	weight = ratio * UTHREAD_GROUP_WEIGHT_DEFAULT;
+	uthread_run_config(&config, thread0, NULL);
+
+	uint64_t runtime = uthread_group_runtime(one);
+	uint64_t total = runtime + uthread_group_runtime(many);
+	int share = total > 0 ? (int)(runtime * 100 / total) : 0;
+	int expected = 100 * ratio / (ratio + 1);
+
+	printf("1 vs %d threads, weights %u:1: ", THREADS, ratio);
+	if (share >= expected - TOLERANCE && share <= expected + TOLERANCE) {
+		printf("share ok\n");
+	} else {
+		printf("FAIL (%d%%, expected %d%%)\n", share, expected);
+	}
+
+	// Groups are empty once their threads are done
+	bool destroyed = !uthread_group_destroy(one) && !uthread_group_destroy(many);
+
+	return destroyed;
+}
+
+int main(void)
+{
+	bool destroyed = run(1);
+
+	destroyed = run(3) && destroyed;
+	printf("groups %s\n", destroyed ? "destroyed" : "FAIL");
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Offload test
+ *
+ * A thread sleeps on a helper kernel thread while another one keeps running.
+ * Then several threads sleep at the same time, on different helpers, the same
+ * is done by threads on the shared stack, and a call made outside of the
+ * library runs directly. The program should output:
+ *
+ * offload: ran on helper, other thread kept running
+ * parallel: 8 calls overlapped
+ * shared: ok
+ * direct: ok
+ */
+
+#define _GNU_SOURCE
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <offload.h>
+#include <uthread.h>
+
+#define CALLS 8
+#define SLEEP_MS 50
+
+static pid_t schedTid;
+static atomic_bool onHelper;
+static bool done;
+static unsigned long spins;
+
+static void sleep_ms(void *arg)
+{
+	struct timespec ts = {0, (intptr_t)arg * 1000000L};
+
+	if (gettid() != schedTid) {
+		atomic_store(&onHelper, true);
+	}
+	nanosleep(&ts, NULL);
+}
+
+static void sleeper(void *arg)
+{
+	(void)arg;
+	uthread_offload(sleep_ms, (void *)(intptr_t)SLEEP_MS);
+	done = true;
+}
+
+static void spinner(void *arg)
+{
+	(void)arg;
+	while (!done) {
+		spins++;
+		uthread_yield();
+	}
+}
+
+static void start(void *arg)
+{
+	(void)arg;
+	schedTid = gettid();
+	uthread_create(sleeper, NULL);
+	uthread_create(spinner, NULL);
+}
+
+static void parallel(void *arg)
+{
+	(void)arg;
+	for (int i = 0; i < CALLS; i++) {
+		uthread_create(sleeper, NULL);
+	}
+}
+
+static void shared(void *arg)
+{
+	(void)arg;
+	done = false;
+	uthread_create_shared(sleeper, NULL, NULL);
+	uthread_create_shared(spinner, NULL, NULL);
+}
+
+static uint64_t now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int main(void)
+{
+	uthread_run(false, start, NULL);
+	printf("offload: %s, %s\n",
+	       atomic_load(&onHelper) ? "ran on helper" : "FAIL",
+	       spins > 0 ? "other thread kept running" : "FAIL");
+
+	// At most half of them wait for a helper
+	uint64_t begin = now_ms();
+	uthread_run(false, parallel, NULL);
+	uint64_t elapsed = now_ms() - begin;
+	printf("parallel: %d calls %s\n", CALLS,
+	       elapsed < CALLS * SLEEP_MS / 2 + SLEEP_MS ? "overlapped" : "FAIL");
+
+	// Spinner overwrites the shared stack while the sleeper is away
+	spins = 0;
+	uthread_run(false, shared, NULL);
+	printf("shared: %s\n", done && spins > 0 ? "ok" : "FAIL");
+
+	schedTid = gettid();
+	atomic_store(&onHelper, false);
+	int ret = uthread_offload(sleep_ms, (void *)1);
+	printf("direct: %s\n", ret == 0 && !atomic_load(&onHelper) ? "ok" : "FAIL");
+
+	return 0;
+}
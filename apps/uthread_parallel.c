@@ -0,0 +1,118 @@
+/*
+ * Data-parallel loops test
+ *
+ * Squares an array with a parallel loop, then sums it with a parallel
+ * reduction, checking that chunks respect the grain size and that the partial
+ * results of all parts get joined. Chunks that yield overlap, one part per
+ * thread, and a range of a single chunk doesn't create any thread. The program
+ * should output:
+ *
+ * for: 40 chunks, values ok
+ * reduce: 40 chunks, sum ok, 7 joins
+ * overlap: 8 parts at once
+ * single chunk: 0 switches
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <parallel.h>
+#include <uthread.h>
+
+#define SIZE 10000
+#define GRAIN 250
+
+static uint64_t values[SIZE];
+static int chunks;
+static int badChunks;
+static int joins;
+static int active;
+static int mostActive;
+
+static void square(size_t begin, size_t end, void *ctx)
+{
+	(void)ctx;
+
+	chunks++;
+	if (end - begin > GRAIN) {
+		badChunks++;
+	}
+
+	for (size_t i = begin; i < end; i++) {
+		values[i] = (uint64_t)i * i;
+	}
+}
+
+static void sum(size_t begin, size_t end, void *partial, void *ctx)
+{
+	uint64_t *total = partial;
+	(void)ctx;
+
+	chunks++;
+	for (size_t i = begin; i < end; i++) {
+		*total += values[i];
+	}
+}
+
+static void join(void *into, const void *from, void *ctx)
+{
+	(void)ctx;
+
+	joins++;
+	*(uint64_t *)into += *(const uint64_t *)from;
+}
+
+static void overlap(size_t begin, size_t end, void *ctx)
+{
+	(void)begin;
+	(void)end;
+	(void)ctx;
+
+	// Other parts run while this one is switched out
+	if (++active > mostActive) {
+		mostActive = active;
+	}
+	uthread_yield();
+	active--;
+}
+
+static void test(void *arg)
+{
+	(void)arg;
+	struct uthread_stats before, after;
+	uint64_t expected = 0, total = 0;
+
+	for (size_t i = 0; i < SIZE; i++) {
+		expected += (uint64_t)i * i;
+	}
+
+	uthread_parallel_for(0, SIZE, GRAIN, square, NULL);
+	bool ok = badChunks == 0;
+	for (size_t i = 0; i < SIZE; i++) {
+		ok = ok && values[i] == (uint64_t)i * i;
+	}
+	printf("for: %d chunks, values %s\n", chunks, ok ? "ok" : "FAIL");
+
+	chunks = 0;
+	uthread_parallel_reduce(0, SIZE, GRAIN, &total, sizeof(total), sum, join,
+				NULL);
+	printf("reduce: %d chunks, sum %s, %d joins\n", chunks,
+	       total == expected ? "ok" : "FAIL", joins);
+
+	uthread_parallel_for(0, SIZE, GRAIN, overlap, NULL);
+	printf("overlap: %d parts at once\n", mostActive);
+
+	// Running a new thread would have taken a switch
+	uthread_stats(NULL, &before);
+	uthread_parallel_for(0, GRAIN, GRAIN, square, NULL);
+	uthread_stats(NULL, &after);
+	printf("single chunk: %lu switches\n", after.switches - before.switches);
+}
+
+int main(void)
+{
+	uthread_run(false, test, NULL);
+	return 0;
+}
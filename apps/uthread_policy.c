@@ -0,0 +1,87 @@
+/*
+ * Scheduling policy test
+ *
+ * Runs the same threads under several scheduling policies and prints the order
+ * in which they get to run. With the priority policy, the thread given the
+ * highest priority runs first. Thread i runs for 4 - i milliseconds before
+ * yielding, so with the fair-share policy the main thread, which has run the
+ * least, goes next, then the thread that has run the least. The program should
+ * output:
+ *
+ * fifo: 1 2 3 main 1 2 3
+ * lifo: 3 2 1 main 3 2 1
+ * prio: 3 3 1 2 main 1 2
+ * fair: 1 2 3 main 3 2 1
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <policy.h>
+#include <uthread.h>
+
+/*
+ * spin - Use up CPU time
+ */
+static void spin(long ms)
+{
+	struct timespec start, now;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+	do {
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	} while ((now.tv_sec - start.tv_sec) * 1000 +
+		 (now.tv_nsec - start.tv_nsec) / 1000000 < ms);
+}
+
+static void thread(void *arg)
+{
+	printf(" %ld", (long)(intptr_t)arg);
+	spin(4 - (intptr_t)arg);
+	uthread_yield();
+	printf(" %ld", (long)(intptr_t)arg);
+}
+
+static void thread0(void *arg)
+{
+	bool prio = (bool)(intptr_t)arg;
+	uthread_t handle;
+
+	for (intptr_t i = 1; i <= 3; i++) {
+		uthread_create_handle(thread, (void *)i, &handle);
+	}
+
+	// Last thread created runs before everyone else
+	if (prio) {
+		uthread_setprio(handle, UTHREAD_PRIO_DEFAULT - 1);
+	}
+
+	uthread_yield();
+	printf(" main");
+}
+
+static void run(const struct uthread_policy *policy)
+{
+	struct uthread_config config;
+
+	uthread_config_init(&config);
+	config.policy = policy;
+
+	printf("%s:", policy->name);
+	uthread_run_config(&config, thread0,
+			   (void *)(intptr_t)(policy == &uthread_policy_prio));
+	printf("\n");
+}
+
+int main(void)
+{
+	run(&uthread_policy_fifo);
+	run(&uthread_policy_lifo);
+	run(&uthread_policy_prio);
+	run(&uthread_policy_fair);
+
+	return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * Thread pool test
+ *
+ * Runs many short jobs on a pool of two workers and times them against one
+ * thread per job. Then, on a pool of a single worker, a job blocks on a
+ * semaphore that only a later job releases, which only completes if another
+ * worker takes over while the first one is blocked. Last, threads on the shared
+ * stack wait for a pool at the same time. The program should output:
+ *
+ * pool: 10000 jobs, sum ok
+ * threads: 10000 jobs, sum ok
+ * blocking: done, 2 workers
+ * shared: 4 waits ok
+ *
+ * followed by the time taken by the first two.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <pool.h>
+#include <sem.h>
+#include <uthread.h>
+
+#define JOBS 10000
+#define WAITERS 4
+
+static long sum;
+static sem_t sem;
+static uthread_t blockedWorker, releasingWorker;
+static uthread_pool_t sharedPool;
+static int waited;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void job(void *arg)
+{
+	sum += (intptr_t)arg;
+}
+
+static void report(const char *name)
+{
+	long expected = (long)JOBS * (JOBS - 1) / 2;
+
+	printf("%s: %d jobs, sum %s\n", name, JOBS,
+	       sum == expected ? "ok" : "FAIL");
+}
+
+static void job_block(void *arg)
+{
+	(void)arg;
+
+	blockedWorker = uthread_self();
+	sem_down(sem);
+}
+
+static void job_release(void *arg)
+{
+	(void)arg;
+
+	releasingWorker = uthread_self();
+	sem_up(sem);
+}
+
+static void job_yield(void *arg)
+{
+	(void)arg;
+
+	for (int i = 0; i < 10; i++) {
+		uthread_yield();
+	}
+}
+
+static void waiter(void *arg)
+{
+	(void)arg;
+
+	if (uthread_pool_wait(sharedPool) == 0) {
+		waited++;
+	}
+}
+
+static void test(void *arg)
+{
+	(void)arg;
+	double start;
+
+	uthread_pool_t pool = uthread_pool_create(2);
+
+	start = now();
+	for (intptr_t i = 0; i < JOBS; i++) {
+		uthread_pool_submit(pool, job, (void *)i);
+	}
+	uthread_pool_wait(pool);
+	double poolTime = now() - start;
+	report("pool");
+	uthread_pool_destroy(pool);
+
+	sum = 0;
+	start = now();
+	for (intptr_t i = 0; i < JOBS; i++) {
+		uthread_create(job, (void *)i);
+	}
+	while (sum != (long)JOBS * (JOBS - 1) / 2) {
+		uthread_yield();
+	}
+	double threadTime = now() - start;
+	report("threads");
+
+	sem = sem_create(0);
+	pool = uthread_pool_create(1);
+	uthread_pool_submit(pool, job_block, NULL);
+	uthread_pool_submit(pool, job_release, NULL);
+	uthread_pool_destroy(pool);
+	sem_destroy(sem);
+	printf("blocking: done, %d workers\n",
+	       blockedWorker != releasingWorker ? 2 : 1);
+
+	sharedPool = uthread_pool_create(1);
+	uthread_pool_submit(sharedPool, job_yield, NULL);
+	uthread_pool_submit(sharedPool, job_yield, NULL);
+	for (int i = 0; i < WAITERS; i++) {
+		uthread_create_shared(waiter, NULL, NULL);
+	}
+	while (waited < WAITERS) {
+		uthread_yield();
+	}
+	uthread_pool_destroy(sharedPool);
+	printf("shared: %d waits %s\n", WAITERS, waited == WAITERS ? "ok" : "FAIL");
+
+	fprintf(stderr, "pool %.0f us, threads %.0f us\n", poolTime, threadTime);
+}
+
+int main(void)
+{
+	uthread_run(false, test, NULL);
+	return 0;
+}
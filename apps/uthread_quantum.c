@@ -0,0 +1,199 @@
+/*
+ * Time slice test
+ *
+ * Alarms of the preemption timer are counted per running thread, on their way
+ * to the library's handler. In tickless mode, a thread running alone gets no
+ * alarm, as the timer stays disarmed, until another thread gets ready. Then,
+ * with preemption, three threads take turns: one has a 5 ms time slice of its
+ * own, another uses the scheduler's default of 20 ms, and the third yields 2 ms
+ * before the end of each of its slices. Every thread switched to gets a whole
+ * time slice, not the rest of the previous thread's. The program should
+ * output:
+ *
+ * tickless: alone 0 alarms, with competition ok
+ * 5 ms slices: ok
+ * 20 ms slices: ok
+ */
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <policy.h>
+#include <uthread.h>
+
+/* CPU time each CPU-bound thread uses, in milliseconds */
+#define WORK 200
+
+/* Longest clock tick of the system, in milliseconds */
+#define TICK 10
+
+/* Longest time between two clock reads of a running thread, in nanoseconds */
+#define GAP 100000
+
+/* Threads alarms are counted for */
+enum {
+	MAIN,
+	SHORT,
+	LONG,
+	YIELDER,
+	THREADS
+};
+
+static volatile bool done[THREADS];
+static volatile int running;
+static volatile unsigned long alarms[THREADS];
+static void (*libraryHandler)(int);
+
+static void count_alarm(int signum)
+{
+	alarms[running]++;
+	libraryHandler(signum);
+}
+
+/*
+ * count_alarms - Count alarms before the library's handler gets them
+ *
+ * The library installs its handler when uthread_run() starts, so this must be
+ * called from a thread.
+ */
+static void count_alarms(void)
+{
+	struct sigaction sa;
+
+	sigaction(SIGVTALRM, NULL, &sa);
+	libraryHandler = sa.sa_handler;
+	sa.sa_handler = count_alarm;
+	sigaction(SIGVTALRM, &sa, NULL);
+}
+
+/*
+ * spin - Use up CPU time as thread @id
+ *
+ * CPU time is that of the kernel thread, gaps in it are when other threads ran
+ * and don't count.
+ */
+static void spin(int id, long ms)
+{
+	struct timespec ts;
+	int64_t last, now, used = 0;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	last = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+	while (used < ms * 1000000LL) {
+		running = id;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		now = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+		if (now - last < GAP) {
+			used += now - last;
+		}
+		last = now;
+	}
+}
+
+static void competitor(void *arg)
+{
+	(void)arg;
+
+	spin(SHORT, 30);
+}
+
+static void tickless0(void *arg)
+{
+	(void)arg;
+
+	count_alarms();
+
+	// Nothing to preempt the thread for
+	spin(MAIN, 30);
+	unsigned long alone = alarms[MAIN];
+
+	// Timer starts as soon as another thread is ready
+	uthread_create(competitor, NULL);
+	spin(MAIN, 30);
+	unsigned long competing = alarms[MAIN] - alone;
+
+	printf("tickless: alone %lu alarms, with competition %s\n", alone,
+	       competing > 0 ? "ok" : "FAIL");
+}
+
+static void short_slices(void *arg)
+{
+	(void)arg;
+
+	uthread_set_quantum(uthread_self(), 5000);
+	spin(SHORT, WORK);
+	done[SHORT] = true;
+}
+
+static void long_slices(void *arg)
+{
+	(void)arg;
+
+	spin(LONG, WORK);
+	done[LONG] = true;
+}
+
+static void yielder(void *arg)
+{
+	(void)arg;
+
+	while (!done[SHORT] || !done[LONG]) {
+		spin(YIELDER, 18);
+		uthread_yield();
+	}
+}
+
+static void quantum0(void *arg)
+{
+	(void)arg;
+
+	count_alarms();
+	uthread_set_sched_quantum(20000);
+
+	// Long slices always come right after the yielding thread
+	uthread_create(short_slices, NULL);
+	uthread_create(yielder, NULL);
+	uthread_create(long_slices, NULL);
+}
+
+/*
+ * check - Check that a thread got one alarm per time slice
+ *
+ * Timers on CPU time only fire on a clock tick of the system, so slices can
+ * last up to a tick longer.
+ */
+static void check(int quantum, unsigned long count)
+{
+	unsigned long most = WORK / quantum + 1;
+	unsigned long least = WORK / (quantum + TICK) - 1;
+
+	printf("%d ms slices: ", quantum);
+	if (count >= least && count <= most) {
+		printf("ok\n");
+	} else {
+		printf("FAIL (%lu alarms, expected %lu to %lu)\n", count, least,
+		       most);
+	}
+}
+
+int main(void)
+{
+	struct uthread_config config;
+
+	uthread_config_init(&config);
+	config.policy = &uthread_policy_fifo;
+	config.preempt = true;
+	config.tickless = true;
+	uthread_run_config(&config, tickless0, NULL);
+
+	config.tickless = false;
+	alarms[SHORT] = alarms[LONG] = 0;
+	uthread_run_config(&config, quantum0, NULL);
+	check(5, alarms[SHORT]);
+	check(20, alarms[LONG]);
+
+	return 0;
+}
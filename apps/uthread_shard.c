@@ -0,0 +1,158 @@
+/*
+ * Sharded schedulers test
+ *
+ * Several kernel threads each run a scheduler of their own at the same time.
+ * Each one creates threads that yield to one another, then runs two threads
+ * that can only both make progress if preemption works on its kernel thread.
+ * Meanwhile, threads of every scheduler request threads from an extra one. The
+ * program should output:
+ *
+ * shards: 4 schedulers, 4000 threads ok
+ * preempt: 4 schedulers ok
+ * remote: 400 threads ok
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+#define SHARDS 4
+#define THREADS 1000
+#define YIELDS 10
+#define REMOTE 100
+
+struct shard {
+	pthread_t thread;
+	uthread_sched_t sched;
+	int done;
+	bool mixed;
+	bool preempted;
+	atomic_bool flag;
+};
+
+static struct shard shards[SHARDS];
+static uthread_sched_t remoteSched;
+static atomic_int remoteDone;
+
+static void remote(void *arg)
+{
+	(void)arg;
+	atomic_fetch_add(&remoteDone, 1);
+}
+
+static void nothing(void *arg)
+{
+	(void)arg;
+}
+
+static void worker(void *arg)
+{
+	struct shard *shard = arg;
+
+	for (int i = 0; i < YIELDS; i++) {
+		// Never sees a thread of another scheduler
+		if (uthread_sched_self() != shard->sched) {
+			shard->mixed = true;
+		}
+		uthread_yield();
+	}
+	shard->done++;
+}
+
+static void spinner(void *arg)
+{
+	struct shard *shard = arg;
+
+	// Only gets out once the setter ran, which can only preempt it
+	while (!atomic_load(&shard->flag)) {
+	}
+	shard->preempted = true;
+}
+
+static void setter(void *arg)
+{
+	struct shard *shard = arg;
+
+	atomic_store(&shard->flag, true);
+}
+
+static void start(void *arg)
+{
+	struct shard *shard = arg;
+
+	shard->sched = uthread_sched_self();
+	for (int i = 0; i < THREADS; i++) {
+		uthread_create(worker, shard);
+	}
+	for (int i = 0; i < REMOTE; i++) {
+		uthread_spawn_remote(remoteSched, remote, NULL);
+	}
+
+	uthread_create(spinner, shard);
+	uthread_create(setter, shard);
+}
+
+static void *shard_main(void *arg)
+{
+	struct uthread_config config;
+
+	uthread_config_init(&config);
+	config.preempt = true;
+	config.quantum = 1000;
+	uthread_run_config(&config, start, arg);
+
+	return NULL;
+}
+
+static void *remote_main(void *arg)
+{
+	struct uthread_config config;
+
+	(void)arg;
+	uthread_config_init(&config);
+	config.sched = remoteSched;
+	uthread_run_config(&config, nothing, NULL);
+
+	return NULL;
+}
+
+int main(void)
+{
+	pthread_t remoteThread;
+
+	remoteSched = uthread_sched_create();
+	pthread_create(&remoteThread, NULL, remote_main, NULL);
+
+	for (int i = 0; i < SHARDS; i++) {
+		pthread_create(&shards[i].thread, NULL, shard_main, &shards[i]);
+	}
+
+	int done = 0;
+	int preempted = 0;
+	bool ok = true;
+
+	for (int i = 0; i < SHARDS; i++) {
+		pthread_join(shards[i].thread, NULL);
+		done += shards[i].done;
+		preempted += shards[i].preempted;
+		ok = ok && shards[i].done == THREADS && !shards[i].mixed;
+	}
+
+	uthread_sched_stop(remoteSched);
+	pthread_join(remoteThread, NULL);
+	uthread_sched_destroy(remoteSched);
+
+	printf("shards: %d schedulers, %d threads %s\n", SHARDS, done,
+	       ok ? "ok" : "FAIL");
+	printf("preempt: %d schedulers %s\n", preempted,
+	       preempted == SHARDS ? "ok" : "FAIL");
+	printf("remote: %d threads %s\n", atomic_load(&remoteDone),
+	       atomic_load(&remoteDone) == SHARDS * REMOTE ? "ok" : "FAIL");
+
+	return 0;
+}
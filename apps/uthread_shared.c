@@ -0,0 +1,109 @@
+/*
+ * Shared stack test
+ *
+ * Runs many threads on the shared stack alongside normal threads. Each keeps
+ * data on its stack across yields and blocking on a semaphore, which must come
+ * back intact whatever ran on the shared stack in the meantime. The program
+ * should output:
+ *
+ * shared: 10000 threads ok
+ * normal: ok
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define THREADS 10000
+#define ROUNDS 3
+
+static sem_t sem;
+static int ok, failed;
+static int normalOk = 1;
+
+static void check(const int *data, int size, intptr_t id)
+{
+	for (int i = 0; i < size; i++) {
+		if (data[i] != id + i) {
+			failed++;
+			return;
+		}
+	}
+}
+
+static void thread_shared(void *arg)
+{
+	intptr_t id = (intptr_t)arg;
+	int data[64 + id % 64];
+	int size = sizeof(data) / sizeof(data[0]);
+
+	for (int i = 0; i < size; i++) {
+		data[i] = id + i;
+	}
+
+	for (int round = 0; round < ROUNDS; round++) {
+		uthread_yield();
+		check(data, size, id);
+	}
+
+	// Woken up by the next shared thread to get here
+	if (id > 0) {
+		sem_down(sem);
+		check(data, size, id);
+	}
+	sem_up(sem);
+
+	ok++;
+}
+
+static void thread_normal(void *arg)
+{
+	int data[256];
+	(void)arg;
+
+	for (int i = 0; i < 256; i++) {
+		data[i] = -i;
+	}
+	for (int round = 0; round < ROUNDS; round++) {
+		uthread_yield();
+		for (int i = 0; i < 256; i++) {
+			if (data[i] != -i) {
+				normalOk = 0;
+			}
+		}
+	}
+}
+
+static void thread0(void *arg)
+{
+	(void)arg;
+
+	for (intptr_t i = 0; i < THREADS; i++) {
+		if (uthread_create_shared(thread_shared, (void *)i, NULL) == -1) {
+			printf("shared: FAIL to create\n");
+			return;
+		}
+		if (i % 1000 == 0) {
+			uthread_create(thread_normal, NULL);
+		}
+	}
+}
+
+int main(void)
+{
+	sem = sem_create(0);
+	uthread_run(true, thread0, NULL);
+	sem_destroy(sem);
+
+	if (ok == THREADS && failed == 0) {
+		printf("shared: %d threads ok\n", THREADS);
+	} else {
+		printf("shared: FAIL (%d ok, %d corrupted)\n", ok, failed);
+	}
+	printf("normal: %s\n", normalOk ? "ok" : "FAIL");
+
+	return 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * Remote spawn test
+ *
+ * Other kernel threads request threads from a scheduler created beforehand,
+ * which keeps waiting for requests until stopped. Threads also request threads
+ * from their own scheduler, and requests made after the stop are rejected.
+ * Producers racing with the stop get every accepted request run. The program
+ * should output:
+ *
+ * remote: 4 producers, 40000 threads ok
+ * local: 100 threads ok
+ * stopped: rejected
+ * race: 200 rounds ok
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+#define PRODUCERS 4
+#define SPAWNS 10000
+#define LOCAL 100
+#define ROUNDS 200
+#define RACE_SPAWNS 100
+
+static uthread_sched_t sched;
+static atomic_int done;
+static atomic_long sum;
+static int local;
+static atomic_bool rejected;
+
+static atomic_int accepted;
+static atomic_int ran;
+
+static void work(void *arg)
+{
+	atomic_fetch_add(&sum, (intptr_t)arg);
+	atomic_fetch_add(&done, 1);
+}
+
+static void *producer(void *arg)
+{
+	(void)arg;
+
+	for (intptr_t i = 1; i <= SPAWNS; i++) {
+		while (uthread_spawn_remote(sched, work, (void *)i)) {
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+static void child(void *arg)
+{
+	(void)arg;
+	local++;
+}
+
+static void start(void *arg)
+{
+	(void)arg;
+
+	for (int i = 0; i < LOCAL; i++) {
+		uthread_spawn_remote(uthread_sched_self(), child, NULL);
+	}
+}
+
+static void *stopper(void *arg)
+{
+	(void)arg;
+
+	while (atomic_load(&done) < PRODUCERS * SPAWNS) {
+		sched_yield();
+	}
+	uthread_sched_stop(sched);
+	atomic_store(&rejected, uthread_spawn_remote(sched, work, NULL) == -1);
+
+	return NULL;
+}
+
+static void count(void *arg)
+{
+	(void)arg;
+	atomic_fetch_add(&ran, 1);
+}
+
+static void nothing(void *arg)
+{
+	(void)arg;
+}
+
+static void *racer(void *arg)
+{
+	(void)arg;
+
+	// Until rejected by the stop, which can come in the middle of a request
+	while (uthread_spawn_remote(sched, count, NULL) == 0) {
+		atomic_fetch_add(&accepted, 1);
+		sched_yield();
+	}
+
+	return NULL;
+}
+
+static void *race_stopper(void *arg)
+{
+	(void)arg;
+
+	while (atomic_load(&accepted) < RACE_SPAWNS) {
+		sched_yield();
+	}
+	uthread_sched_stop(sched);
+
+	return NULL;
+}
+
+/*
+ * race - Stop schedulers while producers keep making requests
+ *
+ * Return: true if every accepted request was run
+ */
+static bool race(void)
+{
+	struct uthread_config config;
+	pthread_t producers[PRODUCERS];
+	pthread_t stop;
+
+	for (int round = 0; round < ROUNDS; round++) {
+		atomic_store(&accepted, 0);
+		atomic_store(&ran, 0);
+		sched = uthread_sched_create();
+
+		for (int i = 0; i < PRODUCERS; i++) {
+			pthread_create(&producers[i], NULL, racer, NULL);
+		}
+		pthread_create(&stop, NULL, race_stopper, NULL);
+
+		uthread_config_init(&config);
+		config.sched = sched;
+		uthread_run_config(&config, nothing, NULL);
+
+		for (int i = 0; i < PRODUCERS; i++) {
+			pthread_join(producers[i], NULL);
+		}
+		pthread_join(stop, NULL);
+		uthread_sched_destroy(sched);
+
+		if (atomic_load(&ran) != atomic_load(&accepted)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(void)
+{
+	struct uthread_config config;
+	pthread_t producers[PRODUCERS];
+	pthread_t stop;
+
+	sched = uthread_sched_create();
+
+	for (int i = 0; i < PRODUCERS; i++) {
+		pthread_create(&producers[i], NULL, producer, NULL);
+	}
+	pthread_create(&stop, NULL, stopper, NULL);
+
+	uthread_config_init(&config);
+	config.sched = sched;
+	uthread_run_config(&config, start, NULL);
+
+	for (int i = 0; i < PRODUCERS; i++) {
+		pthread_join(producers[i], NULL);
+	}
+	pthread_join(stop, NULL);
+
+	long expected = (long)PRODUCERS * SPAWNS * (SPAWNS + 1) / 2;
+	printf("remote: %d producers, %d threads %s\n", PRODUCERS,
+	       PRODUCERS * SPAWNS, atomic_load(&sum) == expected ? "ok" : "FAIL");
+	printf("local: %d threads %s\n", LOCAL, local == LOCAL ? "ok" : "FAIL");
+	printf("stopped: %s\n", atomic_load(&rejected) ? "rejected" : "FAIL");
+
+	uthread_sched_destroy(sched);
+
+	printf("race: %d rounds %s\n", ROUNDS, race() ? "ok" : "FAIL");
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * Stack usage test
+ *
+ * Runs threads that use little stack and threads that use a lot of it, with
+ * stack usage measures enabled, and checks what was measured for each entry
+ * function. The program should output:
+ *
+ * shallow: 4 threads, ok
+ * deep: 2 threads, ok
+ *
+ * The library's report is printed to standard error.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+#define DEEP_SIZE 16384
+
+static void thread_shallow(void *arg)
+{
+	(void)arg;
+	uthread_yield();
+}
+
+static void thread_deep(void *arg)
+{
+	volatile char buffer[DEEP_SIZE];
+	(void)arg;
+
+	for (int i = 0; i < DEEP_SIZE; i++) {
+		buffer[i] = 1;
+	}
+	uthread_yield();
+
+	if (buffer[0] != 1) {
+		printf("deep: FAIL, stack corrupted\n");
+	}
+}
+
+static void thread0(void *arg)
+{
+	(void)arg;
+
+	for (int i = 0; i < 4; i++) {
+		uthread_create(thread_shallow, NULL);
+	}
+	for (int i = 0; i < 2; i++) {
+		uthread_create(thread_deep, NULL);
+	}
+}
+
+static void check(const char *name, uthread_func_t func, size_t min, size_t max)
+{
+	struct uthread_stack_usage usage[8];
+	size_t n = uthread_stack_usage(usage, 8);
+
+	for (size_t i = 0; i < n; i++) {
+		if (usage[i].func != func) {
+			continue;
+		}
+
+		printf("%s: %lu threads, %s\n", name, usage[i].threads,
+		       usage[i].max >= min && usage[i].max < max ? "ok" : "FAIL");
+		return;
+	}
+
+	printf("%s: FAIL, not measured\n", name);
+}
+
+int main(void)
+{
+	struct uthread_config config;
+
+	uthread_config_init(&config);
+	config.stack_usage = true;
+
+	uthread_run_config(&config, thread0, NULL);
+
+	check("shallow", thread_shallow, 1, 4096);
+	check("deep", thread_deep, DEEP_SIZE, DEEP_SIZE + 4096);
+
+	return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Thread-local storage test
+ *
+ * Tests that each thread sees its own value for a key, even when threads
+ * interleave, and that destructors run when threads exit. The program should
+ * output:
+ *
+ * thread1: 1
+ * thread2: 2
+ * thread1: 1
+ * thread2: 2
+ * destructors: 2
+ * reused key: NULL
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+uthread_key_t key;
+int destroyed;
+
+static void destructor(void *value)
+{
+	(void)value;
+	destroyed++;
+}
+
+static void thread(void *arg)
+{
+	int id = *(int *)arg;
+
+	uthread_setspecific(key, arg);
+	uthread_set_userdata(arg);
+	uthread_yield();
+
+	printf("thread%d: %d\n", id, *(int *)uthread_getspecific(key));
+	uthread_yield();
+
+	printf("thread%d: %d\n", id, *(int *)uthread_get_userdata());
+}
+
+static void thread0(void *arg)
+{
+	(void)arg;
+	static int ids[] = {1, 2};
+
+	uthread_create(thread, &ids[0]);
+	uthread_create(thread, &ids[1]);
+}
+
+static void reuser(void *arg)
+{
+	(void)arg;
+	static int value = 3;
+	uthread_key_t reused;
+
+	// Value left behind by a deleted key is not seen through the next one
+	uthread_setspecific(key, &value);
+	uthread_key_delete(key);
+	if (uthread_getspecific(key) != NULL ||
+	    uthread_key_create(&reused, destructor) || reused != key) {
+		printf("reused key: FAIL\n");
+		return;
+	}
+
+	// Nor is it handed to the new key's destructor on exit
+	printf("reused key: %s\n",
+	       uthread_getspecific(reused) == NULL ? "NULL" : "FAIL");
+}
+
+int main(void)
+{
+	if (uthread_key_create(&key, destructor)) {
+		fprintf(stderr, "uthread_key_create failed\n");
+		return 1;
+	}
+
+	uthread_run(false, thread0, NULL);
+	printf("destructors: %d\n", destroyed);
+
+	uthread_run(false, reuser, NULL);
+	if (destroyed != 2) {
+		printf("destructors: FAIL\n");
+	}
+
+	uthread_key_delete(key);
+
+	return 0;
+}
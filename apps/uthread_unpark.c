@@ -0,0 +1,132 @@
+/*
+ * Remote wake-up test
+ *
+ * Threads wait in uthread_park() for a value that another kernel thread
+ * increases, round after round, waking them up with uthread_unpark() while the
+ * scheduler sleeps. Then a thread is woken up from a signal handler. The
+ * program should output:
+ *
+ * remote: 4 threads, 1000 rounds ok
+ * signal: woken
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <uthread.h>
+
+#define THREADS 4
+#define ROUNDS 1000
+
+static uthread_t handles[THREADS];
+static atomic_int values[THREADS];
+static atomic_int acks;
+static atomic_bool started;
+static bool ok = true;
+
+static pthread_t mainThread;
+static _Atomic(uthread_t) sleeper;
+static atomic_bool woken;
+
+static void waiter(void *arg)
+{
+	intptr_t i = (intptr_t)arg;
+
+	for (int round = 1; round <= ROUNDS; round++) {
+		while (atomic_load(&values[i]) < round) {
+			uthread_park();
+		}
+		if (atomic_load(&values[i]) != round) {
+			ok = false;
+		}
+		atomic_fetch_add(&acks, 1);
+	}
+}
+
+static void *producer(void *arg)
+{
+	(void)arg;
+
+	while (!atomic_load(&started)) {
+		sched_yield();
+	}
+
+	for (int round = 1; round <= ROUNDS; round++) {
+		for (int i = 0; i < THREADS; i++) {
+			atomic_store(&values[i], round);
+			uthread_unpark(handles[i]);
+		}
+
+		// Next round once every thread has seen this one
+		while (atomic_load(&acks) < round * THREADS) {
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+static void start(void *arg)
+{
+	(void)arg;
+
+	for (intptr_t i = 0; i < THREADS; i++) {
+		uthread_create_handle(waiter, (void *)i, &handles[i]);
+	}
+	atomic_store(&started, true);
+}
+
+static void handler(int signum)
+{
+	(void)signum;
+	uthread_unpark(atomic_load(&sleeper));
+}
+
+static void *signaler(void *arg)
+{
+	(void)arg;
+
+	// Thread may or may not be parked yet
+	while (atomic_load(&sleeper) == NULL) {
+		sched_yield();
+	}
+	usleep(1000);
+	pthread_kill(mainThread, SIGUSR1);
+
+	return NULL;
+}
+
+static void sleeping(void *arg)
+{
+	(void)arg;
+
+	atomic_store(&sleeper, uthread_self());
+	uthread_park();
+	atomic_store(&woken, true);
+}
+
+int main(void)
+{
+	pthread_t thread;
+
+	pthread_create(&thread, NULL, producer, NULL);
+	uthread_run(false, start, NULL);
+	pthread_join(thread, NULL);
+	printf("remote: %d threads, %d rounds %s\n", THREADS, ROUNDS,
+	       ok && atomic_load(&acks) == THREADS * ROUNDS ? "ok" : "FAIL");
+
+	mainThread = pthread_self();
+	signal(SIGUSR1, handler);
+	pthread_create(&thread, NULL, signaler, NULL);
+	uthread_run(false, sleeping, NULL);
+	pthread_join(thread, NULL);
+	printf("signal: %s\n", atomic_load(&woken) ? "woken" : "FAIL");
+
+	return 0;
+}
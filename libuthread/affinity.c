@@ -0,0 +1,188 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "private.h"
+
+/* Memory policies, from the kernel's uapi headers */
+#define AFFINITY_MPOL_DEFAULT 0
+#define AFFINITY_MPOL_PREFERRED 1
+#define AFFINITY_MPOL_MF_MOVE (1 << 1)
+
+/* Number of NUMA nodes supported, and size of a node mask in longs */
+#define AFFINITY_NODES_MAX 1024
+#define AFFINITY_MASK_BITS (8 * sizeof(unsigned long))
+#define AFFINITY_MASK_LONGS (AFFINITY_NODES_MAX / AFFINITY_MASK_BITS)
+
+/*
+ * CPUs the scheduler's kernel thread could run on before uthread_run(), and
+ * whether it was pinned and given a memory policy (both only apply to the
+ * calling kernel thread)
+ */
+static _Thread_local cpu_set_t oldCpus;
+static _Thread_local bool pinned;
+static _Thread_local bool preferred;
+
+/*
+ * affinity_parse - Parse a list of CPUs
+ * @list: CPUs in the kernel's list format, e.g. "0-3,8"
+ * @cpus: Set receiving the CPUs
+ *
+ * Return: 0 if @list was valid, -1 otherwise
+ */
+static int affinity_parse(const char *list, cpu_set_t *cpus)
+{
+	CPU_ZERO(cpus);
+
+	while (*list != '\0' && *list != '\n') {
+		char *end;
+		unsigned long first = strtoul(list, &end, 10);
+		unsigned long last = first;
+
+		if (end == list) {
+			return -1;
+		}
+		if (*end == '-') {
+			list = end + 1;
+			last = strtoul(list, &end, 10);
+			if (end == list || last < first) {
+				return -1;
+			}
+		}
+		if (last >= CPU_SETSIZE) {
+			return -1;
+		}
+
+		for (unsigned long cpu = first; cpu <= last; cpu++) {
+			CPU_SET(cpu, cpus);
+		}
+
+		list = end;
+		if (*list == ',') {
+			list++;
+		}
+	}
+
+	return CPU_COUNT(cpus) > 0 ? 0 : -1;
+}
+
+/*
+ * affinity_node_cpus - Get the CPUs of a NUMA node
+ * @node: Node number
+ * @cpus: Set receiving the CPUs
+ *
+ * Return: 0 if @cpus was filled, -1 if @node doesn't exist or has no CPU
+ */
+static int affinity_node_cpus(int node, cpu_set_t *cpus)
+{
+	char path[64];
+	char list[1024];
+
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		return -1;
+	}
+
+	char *read = fgets(list, sizeof(list), file);
+	fclose(file);
+	if (read == NULL) {
+		return -1;
+	}
+
+	return affinity_parse(list, cpus);
+}
+
+/*
+ * affinity_node_mask - Fill a node mask with a single node
+ */
+static void affinity_node_mask(int node, unsigned long *mask)
+{
+	for (size_t i = 0; i < AFFINITY_MASK_LONGS; i++) {
+		mask[i] = 0;
+	}
+	mask[node / AFFINITY_MASK_BITS] = 1UL << (node % AFFINITY_MASK_BITS);
+}
+
+int affinity_start(const char *cpuList, int node)
+{
+	cpu_set_t cpus;
+
+	pinned = preferred = false;
+
+	if (node >= AFFINITY_NODES_MAX) {
+		return -1;
+	}
+
+	// Explicit CPUs take precedence over the node's
+	if (cpuList != NULL) {
+		if (affinity_parse(cpuList, &cpus)) {
+			return -1;
+		}
+	} else if (node >= 0) {
+		if (affinity_node_cpus(node, &cpus)) {
+			return -1;
+		}
+	}
+
+	if (cpuList != NULL || node >= 0) {
+		if (sched_getaffinity(0, sizeof(oldCpus), &oldCpus) ||
+		    sched_setaffinity(0, sizeof(cpus), &cpus)) {
+			perror("sched_setaffinity");
+			return -1;
+		}
+		pinned = true;
+	}
+
+	// Memory first touched by this kernel thread, which is all of the
+	// threads' stacks and TCBs, comes from the node if it has some left
+	if (node >= 0) {
+		unsigned long mask[AFFINITY_MASK_LONGS];
+
+		affinity_node_mask(node, mask);
+		if (syscall(SYS_set_mempolicy, AFFINITY_MPOL_PREFERRED, mask,
+			    AFFINITY_NODES_MAX + 1)) {
+			perror("set_mempolicy");
+			affinity_stop();
+			return -1;
+		}
+		preferred = true;
+	}
+
+	return 0;
+}
+
+void affinity_stop(void)
+{
+	if (preferred) {
+		syscall(SYS_set_mempolicy, AFFINITY_MPOL_DEFAULT, NULL, 0);
+		preferred = false;
+	}
+
+	if (pinned) {
+		sched_setaffinity(0, sizeof(oldCpus), &oldCpus);
+		pinned = false;
+	}
+}
+
+void affinity_bind(void *addr, size_t len, int node)
+{
+	if (node < 0 || node >= AFFINITY_NODES_MAX) {
+		return;
+	}
+
+	unsigned long mask[AFFINITY_MASK_LONGS];
+
+	affinity_node_mask(node, mask);
+
+	// Only a hint: pages stay where they are if the node is full, missing,
+	// or if the kernel doesn't support NUMA
+	syscall(SYS_mbind, addr, len, AFFINITY_MPOL_PREFERRED, mask,
+		AFFINITY_NODES_MAX + 1, AFFINITY_MPOL_MF_MOVE);
+}
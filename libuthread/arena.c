@@ -0,0 +1,159 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "private.h"
+
+/*
+ * Thread arenas
+ *
+ * A thread's allocations are carved one after the other out of fixed-size
+ * chunks, and never freed on their own. When the thread exits, its chunks all
+ * go back to its scheduler's cache by splicing the list, so that the next
+ * threads reuse them without calling the allocator. Threads of a scheduler
+ * never run at the same time, so the cache needs no lock.
+ */
+
+/* Size of a chunk, header included */
+#define ARENA_CHUNK_SIZE 16384
+
+/* Chunks a scheduler keeps for later, beyond which they are freed */
+#define ARENA_CACHE_MAX 256
+
+/* Alignment of allocations, suitable for any type */
+#define ARENA_ALIGN _Alignof(max_align_t)
+
+struct arena_chunk {
+	struct arena_chunk *next;
+};
+
+/* Size of a chunk's header, so that the memory right after it is aligned */
+#define ARENA_HEADER ((sizeof(struct arena_chunk) + ARENA_ALIGN - 1) & \
+		      ~(ARENA_ALIGN - 1))
+
+/*
+ * arena_large - Allocate memory in a chunk of its own
+ *
+ * Must be called with preemption disabled.
+ */
+static void *arena_large(struct arena *arena, size_t size)
+{
+	if (size > SIZE_MAX - ARENA_HEADER) {
+		return NULL;
+	}
+
+	struct arena_chunk *chunk = malloc(ARENA_HEADER + size);
+	if (chunk == NULL) {
+		return NULL;
+	}
+
+	chunk->next = arena->large;
+	arena->large = chunk;
+
+	return (char *)chunk + ARENA_HEADER;
+}
+
+/*
+ * arena_grow - Start a new chunk
+ *
+ * Must be called with preemption disabled.
+ *
+ * Return: 0 in case of success, -1 in case of failure when allocating memory
+ */
+static int arena_grow(struct arena *arena, struct arena_cache *cache)
+{
+	struct arena_chunk *chunk = cache->chunks;
+
+	if (chunk != NULL) {
+		cache->chunks = chunk->next;
+		cache->count--;
+	} else {
+		chunk = malloc(ARENA_CHUNK_SIZE);
+		if (chunk == NULL) {
+			return -1;
+		}
+	}
+
+	// Rest of the previous chunk is lost, at most a small allocation
+	chunk->next = arena->chunks;
+	if (arena->chunks == NULL) {
+		arena->last = chunk;
+	}
+	arena->chunks = chunk;
+	arena->count++;
+
+	arena->next = (char *)chunk + ARENA_HEADER;
+	arena->end = (char *)chunk + ARENA_CHUNK_SIZE;
+
+	return 0;
+}
+
+void *arena_alloc(struct arena *arena, struct arena_cache *cache, size_t size)
+{
+	if (size > SIZE_MAX - ARENA_ALIGN) {
+		return NULL;
+	}
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+	// Fast path, in the current chunk
+	if ((size_t)(arena->end - arena->next) >= size) {
+		void *ptr = arena->next;
+
+		arena->next += size;
+		return ptr;
+	}
+
+	void *ptr = NULL;
+
+	preempt_disable();
+	if (size > ARENA_CHUNK_SIZE - ARENA_HEADER) {
+		ptr = arena_large(arena, size);
+	} else if (arena_grow(arena, cache) == 0) {
+		ptr = arena->next;
+		arena->next += size;
+	}
+	preempt_enable();
+
+	return ptr;
+}
+
+void arena_release(struct arena *arena, struct arena_cache *cache)
+{
+	while (arena->large != NULL) {
+		struct arena_chunk *chunk = arena->large;
+
+		arena->large = chunk->next;
+		free(chunk);
+	}
+
+	if (arena->chunks != NULL) {
+		if (cache->count + arena->count <= ARENA_CACHE_MAX) {
+			arena->last->next = cache->chunks;
+			cache->chunks = arena->chunks;
+			cache->count += arena->count;
+		} else {
+			while (arena->chunks != NULL) {
+				struct arena_chunk *chunk = arena->chunks;
+
+				arena->chunks = chunk->next;
+				free(chunk);
+			}
+		}
+	}
+
+	arena->chunks = arena->last = NULL;
+	arena->count = 0;
+	arena->next = arena->end = NULL;
+}
+
+void arena_cache_fini(struct arena_cache *cache)
+{
+	while (cache->chunks != NULL) {
+		struct arena_chunk *chunk = cache->chunks;
+
+		cache->chunks = chunk->next;
+		free(chunk);
+	}
+	cache->count = 0;
+}
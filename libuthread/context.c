@@ -1,12 +1,10 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "private.h"
 #include "uthread.h"
 
-/* Size of the stack for a thread (in bytes) */
-#define UTHREAD_STACK_SIZE 32768
-
 void uthread_ctx_switch(uthread_ctx_t *prev, uthread_ctx_t *next)
 {
 	/*
@@ -19,16 +17,6 @@ void uthread_ctx_switch(uthread_ctx_t *prev, uthread_ctx_t *next)
 	}
 }
 
-void *uthread_ctx_alloc_stack(void)
-{
-	return malloc(UTHREAD_STACK_SIZE);
-}
-
-void uthread_ctx_destroy_stack(void *top_of_stack)
-{
-	free(top_of_stack);
-}
-
 /*
  * uthread_ctx_bootstrap - Thread context bootstrap function
  * @func: Function to be executed by the new thread
@@ -74,3 +62,42 @@ int uthread_ctx_init(uthread_ctx_t *uctx, void *top_of_stack,
 	return 0;
 }
 
+int uthread_ctx_init_from(uthread_ctx_t *uctx, const uthread_ctx_t *model,
+			  void *top_of_stack, uthread_func_t func, void *arg)
+{
+	/*
+	 * Copy the state captured in @model instead of capturing it again,
+	 * which saves getcontext()'s system call
+	 */
+	*uctx = *model;
+
+#if defined(__GLIBC__) && (defined(__x86_64__) || defined(__i386__))
+	/*
+	 * The saved floating-point state is pointed to from the context itself,
+	 * and must not be shared with @model
+	 */
+	uctx->uc_mcontext.fpregs = &uctx->__fpregs_mem;
+#endif
+
+	uctx->uc_stack.ss_sp = top_of_stack;
+	uctx->uc_stack.ss_size = UTHREAD_STACK_SIZE;
+
+	makecontext(uctx, (void (*)(void)) uthread_ctx_bootstrap,
+		    2, func, arg);
+
+	return 0;
+}
+
+void *uthread_ctx_stack_pointer(const uthread_ctx_t *uctx)
+{
+#if defined(__x86_64__)
+	return (void *) uctx->uc_mcontext.gregs[REG_RSP];
+#elif defined(__i386__)
+	return (void *) uctx->uc_mcontext.gregs[REG_ESP];
+#elif defined(__aarch64__)
+	return (void *) uctx->uc_mcontext.sp;
+#else
+	(void) uctx;
+	return NULL;
+#endif
+}
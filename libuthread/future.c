@@ -0,0 +1,523 @@
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "future.h"
+#include "pool.h"
+#include "private.h"
+#include "uthread.h"
+
+/*
+ * Thread waiting for some of the futures it is linked to. Allocated rather than
+ * on the thread's stack, which is copied away while the thread is switched out
+ * if it is shared
+ */
+struct future_wait {
+	struct uthread_tcb *thread;
+
+	// Results still needed before waking up, and index of the first
+	// future whose result was set (-1 if none yet)
+	size_t remaining;
+	int index;
+
+	// Next thread to wake up once the result is set, or next wait in the
+	// free list
+	struct future_wait *nextWake;
+};
+
+/*
+ * Entry in a future's list of things to do once its result is set: either
+ * wake up a waiting thread, or call a callback
+ */
+struct future_link {
+	struct future_link *next;
+
+	// Waiting thread, future waited for and its index for the thread,
+	// whether the future's result was set (the future may be gone by the
+	// time the thread wakes up), and next link of the same thread
+	struct future_wait *wait;
+	struct future *future;
+	int index;
+	bool done;
+	struct future_link *nextOwn;
+
+	void (*callback)(void *result, void *arg);
+	void *arg;
+};
+
+struct future {
+	uthread_async_func_t func;
+	void *arg;
+
+	// Result, whether it is set, whether the thread setting it is done
+	// with the future, and whether the future is deallocated right then
+	void *result;
+	bool done;
+	bool running;
+	bool detached;
+	struct future_link *links;
+
+	// Next future in the free list
+	struct future *nextFree;
+};
+
+/*
+ * Futures, links and waits no longer in use, reused before asking the
+ * allocator. Like all allocator calls, these lists are only accessed with
+ * preemption disabled, and each kernel thread's scheduler has its own
+ */
+static _Thread_local struct future *freeFutures;
+static _Thread_local struct future_link *freeLinks;
+static _Thread_local struct future_wait *freeWaits;
+
+/*
+ * future_alloc - Get a new future
+ *
+ * Must be called with preemption disabled.
+ */
+static struct future *future_alloc(void)
+{
+	struct future *future = freeFutures;
+
+	if (future != NULL) {
+		freeFutures = future->nextFree;
+		return future;
+	}
+
+	return malloc(sizeof(struct future));
+}
+
+/*
+ * future_free - Put future back in the free list
+ *
+ * Must be called with preemption disabled.
+ */
+static void future_free(struct future *future)
+{
+	future->nextFree = freeFutures;
+	freeFutures = future;
+}
+
+/*
+ * future_link_alloc - Get a new link
+ *
+ * Must be called with preemption disabled.
+ */
+static struct future_link *future_link_alloc(void)
+{
+	struct future_link *link = freeLinks;
+
+	if (link != NULL) {
+		freeLinks = link->next;
+		return link;
+	}
+
+	return malloc(sizeof(struct future_link));
+}
+
+/*
+ * future_link_free - Put link back in the free list
+ *
+ * Must be called with preemption disabled.
+ */
+static void future_link_free(struct future_link *link)
+{
+	link->next = freeLinks;
+	freeLinks = link;
+}
+
+/*
+ * future_wait_alloc - Get a new wait
+ *
+ * Must be called with preemption disabled.
+ */
+static struct future_wait *future_wait_alloc(void)
+{
+	struct future_wait *wait = freeWaits;
+
+	if (wait != NULL) {
+		freeWaits = wait->nextWake;
+		return wait;
+	}
+
+	return malloc(sizeof(struct future_wait));
+}
+
+/*
+ * future_wait_free - Put wait back in the free list
+ *
+ * Must be called with preemption disabled.
+ */
+static void future_wait_free(struct future_wait *wait)
+{
+	wait->nextWake = freeWaits;
+	freeWaits = wait;
+}
+
+/*
+ * future_set - Set the result of a future
+ * @future: Future whose function returned
+ * @result: Value returned
+ *
+ * Wake up the threads that don't need to wait any longer, and call the
+ * callbacks.
+ */
+static void future_set(struct future *future, void *result)
+{
+	preempt_disable();
+
+	future->result = result;
+	future->done = true;
+
+	// Links of waiting threads belong to them, and are freed once they wake
+	// up. Only the callbacks are kept
+	struct future_link *callbacks = NULL;
+	struct future_wait *wake = NULL;
+
+	for (struct future_link *link = future->links, *next; link != NULL; link = next) {
+		next = link->next;
+
+		if (link->callback != NULL) {
+			link->next = callbacks;
+			callbacks = link;
+			continue;
+		}
+
+		// Link is off the future's list, whether the thread wakes up now
+		// or not
+		link->done = true;
+
+		struct future_wait *wait = link->wait;
+		if (wait->remaining == 0) {
+			// Already about to wake up, for another future
+			continue;
+		}
+
+		if (wait->index < 0) {
+			wait->index = link->index;
+		}
+		if (--wait->remaining == 0) {
+			wait->nextWake = wake;
+			wake = wait;
+		}
+	}
+	future->links = NULL;
+
+	preempt_enable();
+
+	// Woken threads return right away, so their structure must be read first
+	while (wake != NULL) {
+		struct future_wait *next = wake->nextWake;
+
+		uthread_unblock(wake->thread);
+		wake = next;
+	}
+
+	while (callbacks != NULL) {
+		struct future_link *next = callbacks->next;
+
+		callbacks->callback(result, callbacks->arg);
+
+		preempt_disable();
+		future_link_free(callbacks);
+		preempt_enable();
+		callbacks = next;
+	}
+
+	// Future may have been destroyed meanwhile, nobody else deallocates it
+	preempt_disable();
+	future->running = false;
+	if (future->detached) {
+		future_free(future);
+	}
+	preempt_enable();
+}
+
+/*
+ * future_bootstrap - Run the function of a future and set its result
+ */
+static void future_bootstrap(void *arg)
+{
+	struct future *future = arg;
+
+	future_set(future, future->func(future->arg));
+}
+
+/*
+ * future_create - Allocate a future for a function
+ *
+ * Return: Pointer to new future, or NULL in case of failure
+ */
+static struct future *future_create(uthread_async_func_t func, void *arg)
+{
+	preempt_disable();
+	struct future *future = future_alloc();
+	preempt_enable();
+	if (future == NULL) {
+		return NULL;
+	}
+
+	future->func = func;
+	future->arg = arg;
+	future->result = NULL;
+	future->done = false;
+	future->running = true;
+	future->detached = false;
+	future->links = NULL;
+
+	return future;
+}
+
+uthread_future_t uthread_async(uthread_async_func_t func, void *arg)
+{
+	if (func == NULL) {
+		return NULL;
+	}
+
+	struct future *future = future_create(func, arg);
+	if (future == NULL) {
+		return NULL;
+	}
+
+	if (uthread_create(future_bootstrap, future)) {
+		preempt_disable();
+		future_free(future);
+		preempt_enable();
+		return NULL;
+	}
+
+	return future;
+}
+
+uthread_future_t uthread_pool_async(uthread_pool_t pool, uthread_async_func_t func,
+				    void *arg)
+{
+	if (pool == NULL || func == NULL) {
+		return NULL;
+	}
+
+	struct future *future = future_create(func, arg);
+	if (future == NULL) {
+		return NULL;
+	}
+
+	if (uthread_pool_submit(pool, future_bootstrap, future)) {
+		preempt_disable();
+		future_free(future);
+		preempt_enable();
+		return NULL;
+	}
+
+	return future;
+}
+
+/*
+ * future_unlink - Remove a waiting thread's link from its future
+ *
+ * Must be called with preemption disabled.
+ */
+static void future_unlink(struct future_link *link)
+{
+	struct future_link **prev = &link->future->links;
+
+	while (*prev != link) {
+		prev = &(*prev)->next;
+	}
+	*prev = link->next;
+}
+
+/*
+ * future_wait - Wait for the results of some futures
+ * @futures: Array of futures
+ * @n: Number of futures in @futures
+ * @count: Number of results needed, at most @n
+ *
+ * The calling thread is linked to every future whose result is not set yet,
+ * and blocked until @count results are set.
+ *
+ * Return: -1 in case of failure when allocating memory. Index of the first
+ * future found with its result set otherwise.
+ */
+static int future_wait(uthread_future_t futures[], size_t n, size_t count)
+{
+	int index = -1;
+
+	preempt_disable();
+
+	for (size_t i = 0; i < n && count > 0; i++) {
+		if (futures[i]->done) {
+			if (index < 0) {
+				index = i;
+			}
+			count--;
+		}
+	}
+
+	if (count == 0) {
+		preempt_enable();
+		return index;
+	}
+
+	struct future_wait *wait = future_wait_alloc();
+	if (wait == NULL) {
+		preempt_enable();
+		return -1;
+	}
+
+	wait->thread = uthread_current();
+	wait->remaining = count;
+	wait->index = index;
+
+	struct future_link *links = NULL;
+
+	for (size_t i = 0; i < n; i++) {
+		if (futures[i]->done) {
+			continue;
+		}
+
+		struct future_link *link = future_link_alloc();
+		if (link == NULL) {
+			// Undo what was done so far
+			for (; links != NULL; links = links->nextOwn) {
+				future_unlink(links);
+				future_link_free(links);
+			}
+			future_wait_free(wait);
+			preempt_enable();
+			return -1;
+		}
+
+		link->wait = wait;
+		link->future = futures[i];
+		link->index = i;
+		link->done = false;
+		link->callback = NULL;
+		link->nextOwn = links;
+		links = link;
+
+		link->next = futures[i]->links;
+		futures[i]->links = link;
+	}
+
+	// Single wake-up, once enough results are set (preemption is enabled
+	// again on resume)
+	uthread_block();
+
+	// Futures whose result is still not set keep a link to this thread
+	preempt_disable();
+	while (links != NULL) {
+		struct future_link *next = links->nextOwn;
+
+		if (!links->done) {
+			future_unlink(links);
+		}
+
+		future_link_free(links);
+		links = next;
+	}
+
+	index = wait->index;
+	future_wait_free(wait);
+	preempt_enable();
+
+	return index;
+}
+
+int uthread_await(uthread_future_t future, void **result)
+{
+	if (future == NULL) {
+		return -1;
+	}
+
+	if (!future->done && future_wait(&future, 1, 1) < 0) {
+		return -1;
+	}
+
+	if (result != NULL) {
+		*result = future->result;
+	}
+
+	return 0;
+}
+
+int uthread_await_all(uthread_future_t futures[], size_t n)
+{
+	if (futures == NULL || n > INT_MAX) {
+		return -1;
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (futures[i] == NULL) {
+			return -1;
+		}
+	}
+
+	if (n == 0) {
+		return 0;
+	}
+
+	return future_wait(futures, n, n) < 0 ? -1 : 0;
+}
+
+int uthread_await_any(uthread_future_t futures[], size_t n)
+{
+	if (futures == NULL || n == 0 || n > INT_MAX) {
+		return -1;
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (futures[i] == NULL) {
+			return -1;
+		}
+	}
+
+	return future_wait(futures, n, 1);
+}
+
+int uthread_future_then(uthread_future_t future,
+			void (*callback)(void *result, void *arg), void *arg)
+{
+	if (future == NULL || callback == NULL) {
+		return -1;
+	}
+
+	preempt_disable();
+
+	if (future->done) {
+		preempt_enable();
+		callback(future->result, arg);
+		return 0;
+	}
+
+	struct future_link *link = future_link_alloc();
+	if (link == NULL) {
+		preempt_enable();
+		return -1;
+	}
+
+	link->callback = callback;
+	link->arg = arg;
+	link->next = future->links;
+	future->links = link;
+
+	preempt_enable();
+
+	return 0;
+}
+
+int uthread_future_destroy(uthread_future_t future)
+{
+	if (future == NULL) {
+		return -1;
+	}
+
+	preempt_disable();
+	if (!future->running) {
+		future_free(future);
+	} else {
+		// Deallocated once its result is set and its callbacks called
+		future->detached = true;
+	}
+	preempt_enable();
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+#ifndef _FUTURE_H
+#define _FUTURE_H
+
+#include <stddef.h>
+
+#include "pool.h"
+#include "uthread.h"
+
+/*
+ * uthread_future_t - Future type
+ *
+ * A future holds the result of a function running asynchronously, in a thread
+ * of its own or in a thread pool. Threads can wait for the results of one or
+ * several futures at once, blocking only until the results they need are
+ * available, and callbacks can be attached to run as soon as a result is set.
+ *
+ * Futures are recycled once destroyed, so that creating many of them doesn't
+ * go through the allocator each time.
+ */
+typedef struct future *uthread_future_t;
+
+/*
+ * uthread_async_func_t - Asynchronous function type
+ * @arg: Argument to be passed to the function
+ *
+ * Return: Result of the function, which the future receives
+ */
+typedef void *(*uthread_async_func_t)(void *arg);
+
+/*
+ * uthread_async - Run a function asynchronously in a new thread
+ * @func: Function to run
+ * @arg: Argument to be passed to @func
+ *
+ * Return: Pointer to the future receiving the result of @func. NULL if @func is
+ * NULL or in case of failure (e.g., memory allocation, context creation).
+ */
+uthread_future_t uthread_async(uthread_async_func_t func, void *arg);
+
+/*
+ * uthread_pool_async - Run a function asynchronously in a thread pool
+ * @pool: Pool to run the function
+ * @func: Function to run
+ * @arg: Argument to be passed to @func
+ *
+ * Same as uthread_async(), but @func runs as a job of @pool.
+ *
+ * Return: Pointer to the future receiving the result of @func. NULL if @pool or
+ * @func are NULL or in case of failure (e.g., memory allocation).
+ */
+uthread_future_t uthread_pool_async(uthread_pool_t pool, uthread_async_func_t func,
+				    void *arg);
+
+/*
+ * uthread_await - Wait for the result of a future
+ * @future: Future to wait for
+ * @result: Address where the result is received, or NULL
+ *
+ * The calling thread is only blocked if the result is not set yet.
+ *
+ * Return: -1 if @future is NULL or in case of failure when allocating memory.
+ * 0 once the result of @future is set.
+ */
+int uthread_await(uthread_future_t future, void **result);
+
+/*
+ * uthread_await_all - Wait for the results of several futures
+ * @futures: Array of futures to wait for
+ * @n: Number of futures in @futures
+ *
+ * The calling thread is blocked once at most, until the last of the results is
+ * set. Results are then read with uthread_await(), which doesn't block anymore.
+ *
+ * Return: -1 if @futures or one of its futures is NULL, or in case of failure
+ * when allocating memory. 0 once the results of all @futures are set.
+ */
+int uthread_await_all(uthread_future_t futures[], size_t n);
+
+/*
+ * uthread_await_any - Wait for the result of one of several futures
+ * @futures: Array of futures to wait for
+ * @n: Number of futures in @futures
+ *
+ * Return: -1 if @futures or one of its futures is NULL, if @n is 0, or in case
+ * of failure when allocating memory. Index in @futures of a future whose result
+ * is set otherwise, the first one to be set if the calling thread had to wait.
+ */
+int uthread_await_any(uthread_future_t futures[], size_t n);
+
+/*
+ * uthread_future_then - Attach a callback to a future
+ * @future: Future whose result is passed to @callback
+ * @callback: Function to call with the result of @future and @arg
+ * @arg: Argument to be passed to @callback
+ *
+ * @callback is called by the thread that sets the result, right after it is
+ * set, or right away by the calling thread if it is already set. Callbacks
+ * attached to a same future are called in no particular order.
+ *
+ * Return: -1 if @future or @callback are NULL, or in case of failure when
+ * allocating memory. 0 if @callback was attached or called.
+ */
+int uthread_future_then(uthread_future_t future,
+			void (*callback)(void *result, void *arg), void *arg);
+
+/*
+ * uthread_future_destroy - Deallocate a future
+ * @future: Future to deallocate
+ *
+ * If its result is not set yet, @future is only deallocated once it is, after
+ * its callbacks have been called. No thread must be waiting for @future.
+ *
+ * Return: -1 if @future is NULL. 0 if @future was, or will be, deallocated.
+ */
+int uthread_future_destroy(uthread_future_t future);
+
+#endif /* _FUTURE_H */
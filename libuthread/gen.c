@@ -0,0 +1,138 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "gen.h"
+#include "private.h"
+#include "uthread.h"
+
+struct generator {
+	uthread_func_t func;
+	void *arg;
+
+	// Generator's own thread, and thread waiting for its next value
+	struct uthread_tcb *thread;
+	struct uthread_tcb *consumer;
+
+	void *value;
+	bool done;
+	bool cancelled;
+};
+
+/*
+ * uthread_gen_finish - Terminate generator thread and wake up its consumer
+ */
+static void uthread_gen_finish(struct generator *gen)
+{
+	gen->done = true;
+
+	// Consumer is blocked waiting on this generator
+	uthread_unblock(gen->consumer);
+	uthread_exit();
+}
+
+/*
+ * uthread_gen_bootstrap - Entry point of generator threads
+ */
+static void uthread_gen_bootstrap(void *arg)
+{
+	struct generator *gen = arg;
+
+	// Generator might be destroyed before producing anything
+	if (!gen->cancelled) {
+		gen->func(gen->arg);
+	}
+
+	uthread_gen_finish(gen);
+}
+
+uthread_gen_t uthread_gen_create(uthread_func_t func, void *arg)
+{
+	if (func == NULL) {
+		return NULL;
+	}
+
+	preempt_disable();
+	struct generator *gen = malloc(sizeof(struct generator));
+	preempt_enable();
+	if (gen == NULL) {
+		return NULL;
+	}
+
+	gen->func = func;
+	gen->arg = arg;
+	gen->consumer = NULL;
+	gen->value = NULL;
+	gen->done = false;
+	gen->cancelled = false;
+
+	// Thread stays blocked until its first value is requested
+	gen->thread = uthread_new(uthread_gen_bootstrap, gen);
+	if (gen->thread == NULL) {
+		preempt_disable();
+		free(gen);
+		preempt_enable();
+		return NULL;
+	}
+	gen->thread->generator = gen;
+
+	return gen;
+}
+
+int uthread_gen_next(uthread_gen_t gen, void **value)
+{
+	if (gen == NULL || value == NULL || gen->done) {
+		return -1;
+	}
+
+	// Run generator until it yields or returns
+	gen->consumer = uthread_current();
+	uthread_block_to(gen->thread);
+
+	if (gen->done) {
+		return -1;
+	}
+
+	*value = gen->value;
+
+	return 0;
+}
+
+void uthread_gen_yield(void *value)
+{
+	struct uthread_tcb *thread = uthread_current();
+	if (thread == NULL || thread->generator == NULL) {
+		// Not called from a generator
+		return;
+	}
+
+	struct generator *gen = thread->generator;
+
+	// Hand value over and wait for the next request
+	gen->value = value;
+	uthread_block_to(gen->consumer);
+
+	if (gen->cancelled) {
+		uthread_gen_finish(gen);
+	}
+}
+
+int uthread_gen_destroy(uthread_gen_t gen)
+{
+	if (gen == NULL) {
+		return -1;
+	}
+
+	if (!gen->done) {
+		// Resume generator so that it exits from uthread_gen_yield()
+		gen->cancelled = true;
+		gen->consumer = uthread_current();
+		uthread_block_to(gen->thread);
+	}
+
+	preempt_disable();
+	free(gen);
+	preempt_enable();
+
+	return 0;
+}
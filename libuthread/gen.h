@@ -0,0 +1,64 @@
+#ifndef _GEN_H
+#define _GEN_H
+
+#include "uthread.h"
+
+/*
+ * uthread_gen_t - Generator type
+ *
+ * A generator is a thread producing a sequence of values on demand. Each call
+ * to uthread_gen_next() transfers control directly to the generator's thread,
+ * which runs until it hands back a value with uthread_gen_yield(). Control then
+ * goes directly back to the consumer, without either thread going through the
+ * ready queue.
+ */
+typedef struct generator *uthread_gen_t;
+
+/*
+ * uthread_gen_create - Create a generator
+ * @func: Function producing values with uthread_gen_yield()
+ * @arg: Argument to be passed to @func
+ *
+ * The generator's thread does not start running before the first call to
+ * uthread_gen_next().
+ *
+ * Return: Pointer to new generator. NULL in case of failure (e.g., memory
+ * allocation, context creation).
+ */
+uthread_gen_t uthread_gen_create(uthread_func_t func, void *arg);
+
+/*
+ * uthread_gen_next - Get next value from a generator
+ * @gen: Generator to resume
+ * @value: Address where the produced value is received
+ *
+ * The calling thread is blocked until the generator either yields a value or
+ * returns from its function.
+ *
+ * Return: -1 if @gen or @value are NULL, or if the generator has returned. 0 if
+ * @value was set with the next value.
+ */
+int uthread_gen_next(uthread_gen_t gen, void **value);
+
+/*
+ * uthread_gen_yield - Hand a value to the generator's consumer
+ * @value: Value to produce
+ *
+ * This function must be called from a generator's thread. It returns once the
+ * consumer asks for the next value, and does not return at all if the
+ * generator gets destroyed in the meantime.
+ */
+void uthread_gen_yield(void *value);
+
+/*
+ * uthread_gen_destroy - Deallocate a generator
+ * @gen: Generator to deallocate
+ *
+ * If the generator's function has not returned yet, its thread is made to exit
+ * from its pending uthread_gen_yield().
+ *
+ * Return: -1 if @gen is NULL. 0 if @gen was successfully destroyed.
+ */
+int uthread_gen_destroy(uthread_gen_t gen);
+
+#endif /* _GEN_H */
@@ -0,0 +1,147 @@
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "heap.h"
+
+/* Initial number of nodes a heap can hold */
+#define HEAP_MIN_CAPACITY 16
+
+/*
+ * heap_less - Compare two nodes by key, then by order of insertion
+ */
+static bool heap_less(struct heap_node *a, struct heap_node *b)
+{
+	if (a->key != b->key) {
+		return a->key < b->key;
+	}
+	return a->seq < b->seq;
+}
+
+/*
+ * heap_set - Store node at index and remember index in node
+ */
+static void heap_set(struct heap *heap, size_t i, struct heap_node *node)
+{
+	heap->nodes[i] = node;
+	node->index = i;
+}
+
+static void heap_sift_up(struct heap *heap, size_t i)
+{
+	struct heap_node *node = heap->nodes[i];
+
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		if (!heap_less(node, heap->nodes[parent])) {
+			break;
+		}
+		heap_set(heap, i, heap->nodes[parent]);
+		i = parent;
+	}
+	heap_set(heap, i, node);
+}
+
+static void heap_sift_down(struct heap *heap, size_t i)
+{
+	struct heap_node *node = heap->nodes[i];
+
+	while (true) {
+		size_t child = 2 * i + 1;
+		if (child >= heap->size) {
+			break;
+		}
+		// Pick smaller child
+		if (child + 1 < heap->size &&
+		    heap_less(heap->nodes[child + 1], heap->nodes[child])) {
+			child++;
+		}
+		if (!heap_less(heap->nodes[child], node)) {
+			break;
+		}
+		heap_set(heap, i, heap->nodes[child]);
+		i = child;
+	}
+	heap_set(heap, i, node);
+}
+
+void heap_init(struct heap *heap)
+{
+	heap->nodes = NULL;
+	heap->size = heap->capacity = 0;
+	heap->seq = 0;
+}
+
+void heap_fini(struct heap *heap)
+{
+	free(heap->nodes);
+	heap_init(heap);
+}
+
+int heap_reserve(struct heap *heap, size_t capacity)
+{
+	if (capacity <= heap->capacity) {
+		return 0;
+	}
+
+	// Grow node array, at least twofold
+	size_t grown = heap->capacity ? 2 * heap->capacity : HEAP_MIN_CAPACITY;
+	if (grown < capacity) {
+		grown = capacity;
+	}
+
+	struct heap_node **nodes = realloc(heap->nodes, grown * sizeof(*nodes));
+	if (nodes == NULL) {
+		return -1;
+	}
+	heap->nodes = nodes;
+	heap->capacity = grown;
+
+	return 0;
+}
+
+int heap_insert(struct heap *heap, struct heap_node *node)
+{
+	if (heap_reserve(heap, heap->size + 1)) {
+		return -1;
+	}
+
+	node->seq = heap->seq++;
+	heap_set(heap, heap->size++, node);
+	heap_sift_up(heap, node->index);
+
+	return 0;
+}
+
+struct heap_node *heap_min(struct heap *heap)
+{
+	return heap->size ? heap->nodes[0] : NULL;
+}
+
+struct heap_node *heap_pop(struct heap *heap)
+{
+	struct heap_node *node = heap_min(heap);
+
+	if (node != NULL) {
+		heap_remove(heap, node);
+	}
+
+	return node;
+}
+
+void heap_remove(struct heap *heap, struct heap_node *node)
+{
+	size_t i = node->index;
+	struct heap_node *last = heap->nodes[--heap->size];
+
+	if (last == node) {
+		return;
+	}
+
+	// Move last node in the hole, then restore heap order either way
+	heap_set(heap, i, last);
+	if (i > 0 && heap_less(last, heap->nodes[(i - 1) / 2])) {
+		heap_sift_up(heap, i);
+	} else {
+		heap_sift_down(heap, i);
+	}
+}
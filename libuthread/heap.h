@@ -0,0 +1,86 @@
+#ifndef _HEAP_H
+#define _HEAP_H
+
+/*
+ * This header is only meant to be included by files from the libuthread.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * container_of - Get address of structure from address of one of its members
+ */
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+/*
+ * heap_node - Heap node
+ *
+ * Structures stored in a heap embed a node, so that insertion never allocates
+ * and removal of a given item is O(log n). Items with equal keys come out in
+ * order of insertion.
+ */
+struct heap_node {
+	uint64_t key;
+	uint64_t seq;
+	size_t index;
+};
+
+/*
+ * heap - Binary min-heap of nodes
+ */
+struct heap {
+	struct heap_node **nodes;
+	size_t size;
+	size_t capacity;
+	uint64_t seq;
+};
+
+/*
+ * heap_init - Initialize an empty heap
+ */
+void heap_init(struct heap *heap);
+
+/*
+ * heap_fini - Release memory held by a heap
+ */
+void heap_fini(struct heap *heap);
+
+/*
+ * heap_reserve - Make room for a number of nodes
+ * @capacity: Number of nodes the heap must be able to hold
+ *
+ * Inserting nodes never fails as long as the heap holds at most @capacity.
+ *
+ * Return: -1 in case of memory allocation error, 0 otherwise
+ */
+int heap_reserve(struct heap *heap, size_t capacity);
+
+/*
+ * heap_insert - Insert node with key @node->key
+ *
+ * Return: -1 in case of memory allocation error, 0 otherwise
+ */
+int heap_insert(struct heap *heap, struct heap_node *node);
+
+/*
+ * heap_min - Get node with the smallest key without removing it
+ *
+ * Return: Pointer to node, or NULL if @heap is empty
+ */
+struct heap_node *heap_min(struct heap *heap);
+
+/*
+ * heap_pop - Remove node with the smallest key
+ *
+ * Return: Pointer to removed node, or NULL if @heap is empty
+ */
+struct heap_node *heap_pop(struct heap *heap);
+
+/*
+ * heap_remove - Remove a given node from the heap
+ */
+void heap_remove(struct heap *heap, struct heap_node *node);
+
+#endif /* _HEAP_H */
@@ -0,0 +1,77 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "private.h"
+
+/*
+ * Intrusive multiple-producer single-consumer queue, after Dmitry Vyukov's
+ *
+ * Producers swap themselves in as the head with a single atomic exchange, then
+ * link the previous head to them, so pushing is wait-free and needs no lock.
+ * The consumer pops from the tail. A stub node keeps the queue from ever being
+ * empty, so that producers and consumer never touch the same node unless a
+ * single one is left.
+ *
+ * A pop can find the queue temporarily cut, between a producer's exchange and
+ * its link. The nodes after it are then popped on a later call.
+ */
+
+void inbox_init(struct inbox *inbox)
+{
+	atomic_store(&inbox->stub.next, NULL);
+	atomic_store(&inbox->head, &inbox->stub);
+	inbox->tail = &inbox->stub;
+}
+
+void inbox_push(struct inbox *inbox, struct inbox_node *node)
+{
+	atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+
+	struct inbox_node *prev = atomic_exchange_explicit(&inbox->head, node,
+							   memory_order_acq_rel);
+	atomic_store_explicit(&prev->next, node, memory_order_release);
+}
+
+struct inbox_node *inbox_pop(struct inbox *inbox)
+{
+	struct inbox_node *node = inbox->tail;
+	struct inbox_node *next = atomic_load_explicit(&node->next, memory_order_acquire);
+
+	// Skip over the stub
+	if (node == &inbox->stub) {
+		if (next == NULL) {
+			return NULL;
+		}
+		inbox->tail = node = next;
+		next = atomic_load_explicit(&node->next, memory_order_acquire);
+	}
+
+	if (next != NULL) {
+		inbox->tail = next;
+		return node;
+	}
+
+	// Last node can only go once another one follows it: a producer may be
+	// linking to it, or it is the head and the stub must take its place
+	if (node != atomic_load_explicit(&inbox->head, memory_order_acquire)) {
+		return NULL;
+	}
+
+	inbox_push(inbox, &inbox->stub);
+
+	next = atomic_load_explicit(&node->next, memory_order_acquire);
+	if (next != NULL) {
+		inbox->tail = next;
+		return node;
+	}
+
+	return NULL;
+}
+
+bool inbox_empty(struct inbox *inbox)
+{
+	return inbox->tail == &inbox->stub &&
+	       atomic_load_explicit(&inbox->stub.next, memory_order_acquire) == NULL &&
+	       atomic_load_explicit(&inbox->head, memory_order_acquire) == &inbox->stub;
+}
@@ -0,0 +1,128 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "io.h"
+#include "private.h"
+#include "uthread.h"
+
+/*
+ * io_again - Check if a system call failed only because it would block
+ */
+static bool io_again(void)
+{
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+int uthread_io_wait(int fd, int events)
+{
+	struct uthread_sched *sched = uthread_sched_self();
+
+	if (sched == NULL || events == 0 ||
+	    (events & ~(UTHREAD_IO_READ | UTHREAD_IO_WRITE)) != 0) {
+		return -1;
+	}
+
+	// Reported once, to the scheduler of this kernel thread
+	struct epoll_event event;
+
+	event.events = EPOLLONESHOT;
+	if (events & UTHREAD_IO_READ) {
+		event.events |= EPOLLIN;
+	}
+	if (events & UTHREAD_IO_WRITE) {
+		event.events |= EPOLLOUT;
+	}
+	event.data.ptr = uthread_current();
+
+	// Scheduler only checks for the event once the thread is blocked, so a
+	// tick must not come in between. File descriptor is registered the first
+	// time, and re-armed the next ones
+	preempt_disable();
+
+	if (epoll_ctl(sched->epollFd, EPOLL_CTL_MOD, fd, &event) &&
+	    (errno != ENOENT ||
+	     epoll_ctl(sched->epollFd, EPOLL_CTL_ADD, fd, &event))) {
+		preempt_enable();
+		return -1;
+	}
+
+	sched->ioWaiting++;
+	uthread_block();
+
+	return 0;
+}
+
+ssize_t uthread_read(int fd, void *buf, size_t count)
+{
+	for (;;) {
+		ssize_t ret = read(fd, buf, count);
+
+		if (ret >= 0 || !io_again()) {
+			return ret;
+		}
+		if (uthread_io_wait(fd, UTHREAD_IO_READ)) {
+			return -1;
+		}
+	}
+}
+
+ssize_t uthread_write(int fd, const void *buf, size_t count)
+{
+	for (;;) {
+		ssize_t ret = write(fd, buf, count);
+
+		if (ret >= 0 || !io_again()) {
+			return ret;
+		}
+		if (uthread_io_wait(fd, UTHREAD_IO_WRITE)) {
+			return -1;
+		}
+	}
+}
+
+int uthread_accept(int fd, struct sockaddr *addr, socklen_t *addrlen)
+{
+	for (;;) {
+		int ret = accept4(fd, addr, addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (ret >= 0 || !io_again()) {
+			return ret;
+		}
+		if (uthread_io_wait(fd, UTHREAD_IO_READ)) {
+			return -1;
+		}
+	}
+}
+
+int uthread_connect(int fd, const struct sockaddr *addr, socklen_t addrlen)
+{
+	if (connect(fd, addr, addrlen) == 0) {
+		return 0;
+	}
+	if (errno != EINPROGRESS) {
+		return -1;
+	}
+
+	// Outcome of the connection is known once the socket is writable
+	if (uthread_io_wait(fd, UTHREAD_IO_WRITE)) {
+		return -1;
+	}
+
+	int error;
+	socklen_t len = sizeof(error);
+
+	if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len)) {
+		return -1;
+	}
+	if (error != 0) {
+		errno = error;
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef _IO_H
+#define _IO_H
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include "uthread.h"
+
+/*
+ * Readiness-based I/O
+ *
+ * A thread that waits for a file descriptor is blocked while the other threads
+ * run, and made ready once its scheduler sees the file descriptor ready, which
+ * it checks every few switches, or sleeps on when no thread is ready.
+ *
+ * File descriptors must be in non-blocking mode (O_NONBLOCK), and only waited
+ * for by one thread at a time. Wrappers below retry their system call until it
+ * doesn't fail with EAGAIN, and otherwise behave like it.
+ */
+
+/*
+ * UTHREAD_IO_READ, UTHREAD_IO_WRITE - Readiness to wait for
+ */
+#define UTHREAD_IO_READ 1
+#define UTHREAD_IO_WRITE 2
+
+/*
+ * uthread_io_wait - Wait for a file descriptor to be ready
+ * @fd: File descriptor to wait for
+ * @events: UTHREAD_IO_READ, UTHREAD_IO_WRITE, or both
+ *
+ * The currently running thread is blocked until @fd is ready for one of
+ * @events, or has an error or hang-up pending.
+ *
+ * Return: -1 if called outside of uthread_run(), if @events is invalid, or if
+ * @fd can't be waited for (errno is set). 0 once @fd is ready.
+ */
+int uthread_io_wait(int fd, int events);
+
+/*
+ * uthread_read - Read from a file descriptor, see read(2)
+ */
+ssize_t uthread_read(int fd, void *buf, size_t count);
+
+/*
+ * uthread_write - Write to a file descriptor, see write(2)
+ *
+ * Like write(2), less than @count bytes may be written.
+ */
+ssize_t uthread_write(int fd, const void *buf, size_t count);
+
+/*
+ * uthread_accept - Accept a connection on a socket, see accept(2)
+ *
+ * The socket of the new connection is in non-blocking mode, and closed on
+ * exec.
+ */
+int uthread_accept(int fd, struct sockaddr *addr, socklen_t *addrlen);
+
+/*
+ * uthread_connect - Connect a socket, see connect(2)
+ *
+ * Returns once the connection is established, or failed.
+ */
+int uthread_connect(int fd, const struct sockaddr *addr, socklen_t addrlen);
+
+#endif /* _IO_H */
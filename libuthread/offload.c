@@ -0,0 +1,179 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "offload.h"
+#include "private.h"
+#include "uthread.h"
+
+/*
+ * Progress of a call: not returned yet, returned but its thread is still being
+ * woken up, and done with by the helper
+ */
+#define OFFLOAD_PENDING 0
+#define OFFLOAD_RETURNED 1
+#define OFFLOAD_DONE 2
+
+/*
+ * Call of a blocked thread. Allocated rather than on the thread's stack, which
+ * is copied away while the thread is switched out if it is shared
+ */
+struct offload_call {
+	uthread_func_t func;
+	void *arg;
+	struct uthread_tcb *thread;
+	atomic_int state;
+	struct offload_call *next;
+};
+
+/*
+ * Calls no helper has taken yet, in order, and helpers: started, and waiting
+ * for a call. Shared by the schedulers of all kernel threads, and only accessed
+ * with the lock held
+ */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queued = PTHREAD_COND_INITIALIZER;
+static struct offload_call *head;
+static struct offload_call *tail;
+static unsigned int count;
+static unsigned int helpers;
+static unsigned int idle;
+
+/*
+ * offload_helper - Main loop of helper kernel threads
+ */
+static void *offload_helper(void *arg)
+{
+	(void)arg;
+
+	pthread_mutex_lock(&lock);
+
+	for (;;) {
+		while (head == NULL) {
+			idle++;
+			pthread_cond_wait(&queued, &lock);
+			idle--;
+		}
+
+		struct offload_call *call = head;
+		head = call->next;
+		if (head == NULL) {
+			tail = NULL;
+		}
+		count--;
+
+		pthread_mutex_unlock(&lock);
+
+		call->func(call->arg);
+
+		// Calling thread may see the call returned before it got to park,
+		// but doesn't return (and take the call and its TCB away) until
+		// the helper is done with it
+		struct uthread_tcb *thread = call->thread;
+		atomic_store(&call->state, OFFLOAD_RETURNED);
+		uthread_unpark(thread);
+		atomic_store(&call->state, OFFLOAD_DONE);
+
+		pthread_mutex_lock(&lock);
+	}
+
+	return NULL;
+}
+
+/*
+ * offload_queue - Hand a call over to the helpers
+ *
+ * Must be called with preemption disabled: the lock must not be held across a
+ * tick, which could switch to a thread of the same kernel thread taking it.
+ *
+ * Return: -1 if no helper is running and none could be started, 0 otherwise
+ */
+static int offload_queue(struct offload_call *call)
+{
+	pthread_mutex_lock(&lock);
+
+	// New helper if none is free to take the call. It starts with the
+	// preemption signal blocked, like the calling thread
+	if (count >= idle && helpers < UTHREAD_OFFLOAD_HELPERS) {
+		pthread_t helper;
+
+		if (pthread_create(&helper, NULL, offload_helper, NULL) == 0) {
+			pthread_detach(helper);
+			helpers++;
+		}
+	}
+
+	if (helpers == 0) {
+		pthread_mutex_unlock(&lock);
+		return -1;
+	}
+
+	call->next = NULL;
+	if (tail != NULL) {
+		tail->next = call;
+	} else {
+		head = call;
+	}
+	tail = call;
+	count++;
+
+	pthread_cond_signal(&queued);
+	pthread_mutex_unlock(&lock);
+
+	return 0;
+}
+
+int uthread_offload(uthread_func_t func, void *arg)
+{
+	if (func == NULL) {
+		return -1;
+	}
+
+	// No scheduler to keep running
+	struct uthread_tcb *self = uthread_current();
+	if (self == NULL) {
+		func(arg);
+		return 0;
+	}
+
+	preempt_disable();
+	struct offload_call *call = malloc(sizeof(struct offload_call));
+	preempt_enable();
+	if (call == NULL) {
+		return -1;
+	}
+
+	call->func = func;
+	call->arg = arg;
+	call->thread = self;
+	atomic_init(&call->state, OFFLOAD_PENDING);
+
+	preempt_disable();
+	int queuedCall = offload_queue(call);
+	if (queuedCall) {
+		free(call);
+	}
+	preempt_enable();
+	if (queuedCall) {
+		return -1;
+	}
+
+	// Other wake-ups may come meanwhile
+	while (atomic_load(&call->state) == OFFLOAD_PENDING) {
+		uthread_park();
+	}
+
+	// Helper is only left with waking this thread up, which is short
+	while (atomic_load(&call->state) != OFFLOAD_DONE) {
+		sched_yield();
+	}
+
+	preempt_disable();
+	free(call);
+	preempt_enable();
+
+	return 0;
+}
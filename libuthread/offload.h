@@ -0,0 +1,41 @@
+#ifndef _OFFLOAD_H
+#define _OFFLOAD_H
+
+#include "uthread.h"
+
+/*
+ * Offloading blocking calls
+ *
+ * A thread that makes a blocking call the library can't turn into a
+ * non-blocking one (e.g., getaddrinfo(), open() on a slow disk, or a third-party
+ * library) stops every thread of its scheduler until the call returns. Such a
+ * call can instead be made on one of a few helper kernel threads, shared by all
+ * schedulers of the process, while the calling thread blocks and the others
+ * keep running.
+ */
+
+/*
+ * UTHREAD_OFFLOAD_HELPERS - Most helper kernel threads running at once
+ *
+ * Helpers are started on demand, when no helper is free to take a call, and
+ * then kept for the next calls. Calls made while all helpers are busy wait for
+ * one to be free.
+ */
+#define UTHREAD_OFFLOAD_HELPERS 4
+
+/*
+ * uthread_offload - Run a function on a helper kernel thread
+ * @func: Function to run
+ * @arg: Argument to be passed to @func
+ *
+ * The calling thread is blocked until @func has returned. @func runs outside of
+ * any scheduler, so it must not call functions of the library other than
+ * uthread_unpark() and uthread_spawn_remote(). Called from outside of a thread
+ * of the library, @func is run directly.
+ *
+ * Return: -1 if @func is NULL, in case of failure when allocating memory, or if
+ * no helper was running and none could be started. 0 once @func has returned.
+ */
+int uthread_offload(uthread_func_t func, void *arg);
+
+#endif /* _OFFLOAD_H */
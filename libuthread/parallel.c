@@ -0,0 +1,229 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parallel.h"
+#include "private.h"
+#include "uthread.h"
+
+/* Loop or reduction: chunk size, function called on each chunk, and context */
+struct parallel_body {
+	size_t grain;
+	uthread_range_func_t rangeFunc;
+	uthread_reduce_func_t reduceFunc;
+	void *ctx;
+};
+
+/* Chunks run by one thread, and where they are accumulated into */
+struct parallel_part {
+	struct parallel_body *body;
+	size_t begin;
+	size_t end;
+	void *partial;
+};
+
+/*
+ * Loop or reduction split across threads. Allocated rather than on the
+ * caller's stack, which is copied away while the caller waits if it is shared
+ */
+struct parallel_job {
+	struct parallel_body body;
+
+	// Threads not done yet, and calling thread once it waits for them
+	unsigned int running;
+	struct uthread_tcb *waiter;
+
+	struct parallel_part parts[UTHREAD_PARALLEL_SPLIT];
+	void *args[UTHREAD_PARALLEL_SPLIT];
+};
+
+/* Partial results are allocated after the job, each suitably aligned */
+#define PARALLEL_ALIGN _Alignof(max_align_t)
+#define PARALLEL_ROUND(size) \
+	(((size) + PARALLEL_ALIGN - 1) / PARALLEL_ALIGN * PARALLEL_ALIGN)
+
+/*
+ * parallel_chunk_end - Get end of the chunk starting at a given index
+ */
+static size_t parallel_chunk_end(size_t begin, size_t end, size_t grain)
+{
+	if (grain == 0 || end - begin <= grain) {
+		return end;
+	}
+
+	return begin + grain;
+}
+
+/*
+ * parallel_part_run - Call the function of a loop on every chunk of a part
+ */
+static void parallel_part_run(struct parallel_part *part)
+{
+	struct parallel_body *body = part->body;
+	size_t begin = part->begin;
+
+	while (begin < part->end) {
+		size_t chunkEnd = parallel_chunk_end(begin, part->end, body->grain);
+
+		if (body->reduceFunc != NULL) {
+			body->reduceFunc(begin, chunkEnd, part->partial, body->ctx);
+		} else {
+			body->rangeFunc(begin, chunkEnd, body->ctx);
+		}
+		begin = chunkEnd;
+	}
+}
+
+/*
+ * parallel_main - Entry point of the threads of a job
+ */
+static void parallel_main(void *arg)
+{
+	struct parallel_part *part = arg;
+	struct parallel_job *job = container_of(part->body, struct parallel_job,
+						body);
+
+	parallel_part_run(part);
+
+	// Last thread done wakes the caller up, if it got to wait
+	preempt_disable();
+	if (--job->running == 0 && job->waiter != NULL) {
+		preempt_enable();
+		uthread_unblock(job->waiter);
+		return;
+	}
+	preempt_enable();
+}
+
+/*
+ * parallel_run - Run a loop or a reduction, split across threads
+ * @body: Loop or reduction to run
+ * @begin: First index of the range
+ * @end: Index right after the last one of the range
+ * @result: Partial result of the first part, and identity the others start
+ *	from, or NULL for a loop
+ * @size: Size of @result, in bytes
+ * @join: Function combining two partial results, or NULL for a loop
+ *
+ * The range is cut in up to UTHREAD_PARALLEL_SPLIT parts of whole chunks. The
+ * calling thread runs the first one, and a thread is created for each of the
+ * others. Runs the whole range in the calling thread if it is a single chunk,
+ * if not called from a thread, or if threads can't be created.
+ */
+static void parallel_run(struct parallel_body *body, size_t begin, size_t end,
+			 void *result, size_t size, uthread_join_func_t join)
+{
+	size_t grain = body->grain;
+	size_t chunks = grain == 0 ? 1 : (end - begin) / grain +
+					 ((end - begin) % grain != 0);
+	struct uthread_tcb *self = uthread_current();
+
+	struct parallel_part whole = {body, begin, end, result};
+	if (chunks <= 1 || self == NULL) {
+		parallel_part_run(&whole);
+		return;
+	}
+
+	unsigned int parts = chunks < UTHREAD_PARALLEL_SPLIT ? chunks :
+			     UTHREAD_PARALLEL_SPLIT;
+
+	// Partial results of the parts other than the first one, allocated
+	// along with the job
+	size_t offset = PARALLEL_ROUND(sizeof(struct parallel_job));
+	size_t stride = PARALLEL_ROUND(size);
+	struct parallel_job *job = NULL;
+
+	if (size <= (SIZE_MAX - offset) / UTHREAD_PARALLEL_SPLIT) {
+		preempt_disable();
+		job = malloc(offset + (parts - 1) * stride);
+		preempt_enable();
+	}
+	if (job == NULL) {
+		parallel_part_run(&whole);
+		return;
+	}
+	job->body = *body;
+	job->running = parts - 1;
+	job->waiter = NULL;
+
+	// Parts get the same number of chunks, give or take one
+	size_t each = chunks / parts;
+	size_t extra = chunks % parts;
+	size_t first = 0;
+	char *partials = (char *)job + offset;
+
+	for (unsigned int i = 0; i < parts; i++) {
+		struct parallel_part *part = &job->parts[i];
+		size_t count = each + (i < extra);
+
+		part->body = &job->body;
+		part->begin = begin + first * grain;
+		first += count;
+		part->end = first == chunks ? end : begin + first * grain;
+		part->partial = result;
+		if (result != NULL && i > 0) {
+			part->partial = partials + (i - 1) * stride;
+			memcpy(part->partial, result, size);
+		}
+		job->args[i] = part;
+	}
+
+	if (uthread_create_batch(parts - 1, parallel_main, &job->args[1], NULL)) {
+		preempt_disable();
+		free(job);
+		preempt_enable();
+		parallel_part_run(&whole);
+		return;
+	}
+
+	parallel_part_run(&job->parts[0]);
+
+	// Woken up by the last thread done (preemption is enabled again on
+	// resume)
+	preempt_disable();
+	if (job->running > 0) {
+		job->waiter = self;
+		uthread_block();
+	} else {
+		preempt_enable();
+	}
+
+	for (unsigned int i = 1; i < parts && join != NULL; i++) {
+		join(result, job->parts[i].partial, body->ctx);
+	}
+
+	preempt_disable();
+	free(job);
+	preempt_enable();
+}
+
+int uthread_parallel_for(size_t begin, size_t end, size_t grain,
+			 uthread_range_func_t func, void *ctx)
+{
+	if (func == NULL || end < begin) {
+		return -1;
+	}
+
+	struct parallel_body body = {grain, func, NULL, ctx};
+
+	parallel_run(&body, begin, end, NULL, 0, NULL);
+
+	return 0;
+}
+
+int uthread_parallel_reduce(size_t begin, size_t end, size_t grain,
+			    void *result, size_t size, uthread_reduce_func_t func,
+			    uthread_join_func_t join, void *ctx)
+{
+	if (result == NULL || size == 0 || func == NULL || join == NULL ||
+	    end < begin) {
+		return -1;
+	}
+
+	struct parallel_body body = {grain, NULL, func, ctx};
+
+	parallel_run(&body, begin, end, result, size, join);
+
+	return 0;
+}
@@ -0,0 +1,91 @@
+#ifndef _PARALLEL_H
+#define _PARALLEL_H
+
+#include <stddef.h>
+
+/*
+ * Data-parallel loops
+ *
+ * A range of indices is cut into chunks of at most a given grain size, and a
+ * function is called on each chunk. Chunks run concurrently: they must not
+ * depend on each other, and partial results are combined in no particular
+ * order.
+ *
+ * A range of more than one chunk is split into parts of whole chunks, each run
+ * by its own thread, the calling thread taking the first one. All these threads
+ * run on the calling thread's scheduler, so this pays off when chunks block
+ * (e.g., on I/O) rather than for CPU-bound ones, which are better off with a
+ * large grain size. Outside of a thread, or if threads can't be created, the
+ * chunks run in order in the calling thread.
+ */
+
+/*
+ * UTHREAD_PARALLEL_SPLIT - Most parts a range is split into
+ */
+#define UTHREAD_PARALLEL_SPLIT 8
+
+/*
+ * uthread_range_func_t - Loop body type
+ * @begin: First index of the chunk
+ * @end: Index right after the last one of the chunk
+ * @ctx: Context passed to the loop
+ */
+typedef void (*uthread_range_func_t)(size_t begin, size_t end, void *ctx);
+
+/*
+ * uthread_reduce_func_t - Reduction body type
+ * @begin: First index of the chunk
+ * @end: Index right after the last one of the chunk
+ * @partial: Partial result to accumulate the chunk into
+ * @ctx: Context passed to the reduction
+ */
+typedef void (*uthread_reduce_func_t)(size_t begin, size_t end, void *partial,
+				      void *ctx);
+
+/*
+ * uthread_join_func_t - Partial results combining type
+ * @into: Partial result receiving the combination of both
+ * @from: Other partial result
+ * @ctx: Context passed to the reduction
+ */
+typedef void (*uthread_join_func_t)(void *into, const void *from, void *ctx);
+
+/*
+ * uthread_parallel_for - Call a function on every chunk of a range
+ * @begin: First index of the range
+ * @end: Index right after the last one of the range
+ * @grain: Largest number of indices per chunk, or 0 for a single chunk
+ * @func: Function to call on each chunk
+ * @ctx: Context to be passed to @func
+ *
+ * Return: -1 if @func is NULL or if @end is before @begin. 0 once @func has
+ * been called on the whole range.
+ */
+int uthread_parallel_for(size_t begin, size_t end, size_t grain,
+			 uthread_range_func_t func, void *ctx);
+
+/*
+ * uthread_parallel_reduce - Reduce a range to a single result
+ * @begin: First index of the range
+ * @end: Index right after the last one of the range
+ * @grain: Largest number of indices per chunk, or 0 for a single chunk
+ * @result: Identity of the reduction on entry, result of the reduction on
+ *	return
+ * @size: Size of @result, in bytes, which partial results have too
+ * @func: Function accumulating each chunk into a partial result
+ * @join: Function combining two partial results
+ * @ctx: Context to be passed to @func and @join
+ *
+ * Each part has a partial result, which starts as a copy of the identity. The
+ * first part accumulates into @result itself, and the others are combined into
+ * it with @join once all parts are done. When chunks run in order, @result is
+ * the only partial result and @join isn't called.
+ *
+ * Return: -1 if @result, @func or @join are NULL, if @size is 0, or if @end is
+ * before @begin. 0 once @result holds the result of the reduction.
+ */
+int uthread_parallel_reduce(size_t begin, size_t end, size_t grain,
+			    void *result, size_t size, uthread_reduce_func_t func,
+			    uthread_join_func_t join, void *ctx);
+
+#endif /* _PARALLEL_H */
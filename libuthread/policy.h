@@ -0,0 +1,160 @@
+#ifndef _POLICY_H
+#define _POLICY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "uthread.h"
+
+/*
+ * Enqueue reasons
+ *
+ * Passed to a policy's enqueue operation to tell why a thread becomes ready:
+ * - UTHREAD_ENQUEUE_NEW: thread was just created
+ * - UTHREAD_ENQUEUE_WAKE: thread was blocked and got unblocked
+ * - UTHREAD_ENQUEUE_YIELD: running thread yielded voluntarily
+ * - UTHREAD_ENQUEUE_PREEMPT: running thread was preempted by a timer tick
+ * - UTHREAD_ENQUEUE_REQUEUE: ready thread was removed to change one of its
+ *   scheduling parameters and goes back in
+ */
+enum uthread_enqueue_reason {
+	UTHREAD_ENQUEUE_NEW,
+	UTHREAD_ENQUEUE_WAKE,
+	UTHREAD_ENQUEUE_YIELD,
+	UTHREAD_ENQUEUE_PREEMPT,
+	UTHREAD_ENQUEUE_REQUEUE,
+};
+
+/*
+ * struct uthread_policy - Scheduling policy
+ *
+ * A policy owns the set of ready threads, called run queue, and decides which
+ * one runs next. The library keeps the idle thread out of the run queue, and
+ * always calls the operations with preemption disabled.
+ *
+ * @name: Name of the policy
+ * @init: Allocate a new, empty run queue. Return NULL in case of failure.
+ * @fini: Deallocate an empty run queue
+ * @enqueue: Add a ready thread to the run queue. @reason is one of the
+ *	UTHREAD_ENQUEUE_* values.
+ * @pick_next: Remove the next thread to run from the run queue and return it,
+ *	or return NULL if the run queue is empty
+ * @remove: Remove a given thread from the run queue, for instance when it is
+ *	switched to directly
+ * @on_tick: Optional. Called at each timer tick with the running thread.
+ *	Return true to preempt it. Without this operation, the running thread is
+ *	always preempted.
+ * @on_block: Optional. Called when a running thread blocks or exits.
+ * @on_wake: Optional. Called when a blocked thread is unblocked, before it is
+ *	enqueued. Return true if it should preempt the running thread @current.
+ * @reserve: Optional. Called before threads are created, with the number of
+ *	threads the scheduler then has. Make room for that many ready threads,
+ *	since enqueue can't fail. Return -1 if memory is lacking, in which case
+ *	the threads are not created.
+ */
+struct uthread_policy {
+	const char *name;
+	void *(*init)(void);
+	void (*fini)(void *rq);
+	void (*enqueue)(void *rq, uthread_t thread, int reason);
+	uthread_t (*pick_next)(void *rq);
+	void (*remove)(void *rq, uthread_t thread);
+	bool (*on_tick)(void *rq, uthread_t current);
+	void (*on_block)(void *rq, uthread_t thread);
+	bool (*on_wake)(void *rq, uthread_t thread, uthread_t current);
+	int (*reserve)(void *rq, unsigned int threads);
+};
+
+/*
+ * Policies provided by the library
+ *
+ * - uthread_policy_fifo: round-robin in order of arrival. This is the default
+ *   policy.
+ * - uthread_policy_lifo: newly created or woken threads run first, which keeps
+ *   their working set cache-hot. Threads that yield or get preempted go to the
+ *   back.
+ * - uthread_policy_prio: multi-level feedback queue on thread priorities (see
+ *   uthread_setprio())
+ * - uthread_policy_fair: thread groups get a share of CPU time proportional to
+ *   their weight, whatever their number of threads, and threads of a group
+ *   share it equally (see uthread_group_create())
+ * - uthread_policy_edf: the thread with the earliest deadline (see
+ *   uthread_set_deadline()) runs first, and preempts the running thread as
+ *   soon as it is woken up if its deadline is earlier. Threads without a
+ *   deadline run last.
+ */
+extern const struct uthread_policy uthread_policy_fifo;
+extern const struct uthread_policy uthread_policy_lifo;
+extern const struct uthread_policy uthread_policy_prio;
+extern const struct uthread_policy uthread_policy_fair;
+extern const struct uthread_policy uthread_policy_edf;
+
+/*
+ * uthread_group_t - Thread group type
+ *
+ * Groups are used by the fair-share policy. Threads join the group of the
+ * thread that creates them, and the initial thread belongs to the default
+ * group, which has weight UTHREAD_GROUP_WEIGHT_DEFAULT.
+ */
+typedef struct uthread_group *uthread_group_t;
+
+#define UTHREAD_GROUP_WEIGHT_DEFAULT 1024
+
+/*
+ * uthread_group_create - Create a thread group
+ * @weight: Relative share of CPU time of the group
+ *
+ * Return: Pointer to new group. NULL if @weight is 0 or in case of failure when
+ * allocating the group.
+ */
+uthread_group_t uthread_group_create(unsigned int weight);
+
+/*
+ * uthread_group_destroy - Deallocate a thread group
+ * @group: Group to deallocate
+ *
+ * Return: -1 if @group is NULL or if threads still belong to @group. 0 if
+ * @group was successfully destroyed.
+ */
+int uthread_group_destroy(uthread_group_t group);
+
+/*
+ * uthread_group_set_weight - Change weight of a thread group
+ * @group: Group to modify
+ * @weight: New relative share of CPU time of the group
+ *
+ * Return: -1 if @group is NULL or @weight is 0. 0 if the weight was changed.
+ */
+int uthread_group_set_weight(uthread_group_t group, unsigned int weight);
+
+/*
+ * uthread_group_join - Move a thread to a group
+ * @thread: Handle of thread to move
+ * @group: Group to join, or NULL for the default group
+ *
+ * Return: -1 if @thread is NULL, or in case of failure when allocating memory.
+ * 0 if @thread was moved to @group.
+ */
+int uthread_group_join(uthread_t thread, uthread_group_t group);
+
+/*
+ * uthread_group_runtime - Get CPU time used by a thread group
+ * @group: Group to query
+ *
+ * Return: Time spent running by the threads of @group while scheduled by the
+ * fair-share policy, in nanoseconds, or 0 if @group is NULL
+ */
+uint64_t uthread_group_runtime(uthread_group_t group);
+
+/*
+ * uthread_policy_data - Get a thread's policy-private data slot
+ * @thread: Handle of thread
+ *
+ * Policies defined outside of the library can use this slot to attach their
+ * own bookkeeping to threads.
+ *
+ * Return: Address of @thread's slot, or NULL if @thread is NULL
+ */
+void **uthread_policy_data(uthread_t thread);
+
+#endif /* _POLICY_H */
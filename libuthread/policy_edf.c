@@ -0,0 +1,100 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "heap.h"
+#include "policy.h"
+#include "private.h"
+
+/*
+ * Earliest-deadline-first policy
+ *
+ * Ready threads are kept in a min-heap keyed on their deadline, so the thread
+ * whose deadline is the closest always runs next. Threads without a deadline
+ * only run when no thread with a deadline is ready, in FIFO order among
+ * themselves.
+ */
+
+/*
+ * edf_key - Heap key of a thread
+ */
+static uint64_t edf_key(uthread_t thread)
+{
+	return thread->deadline ? thread->deadline : UINT64_MAX;
+}
+
+static void *edf_init(void)
+{
+	struct heap *heap = malloc(sizeof(struct heap));
+	if (heap == NULL) {
+		return NULL;
+	}
+
+	heap_init(heap);
+
+	return heap;
+}
+
+static void edf_fini(void *rq)
+{
+	heap_fini(rq);
+	free(rq);
+}
+
+static void edf_enqueue(void *rq, uthread_t thread, int reason)
+{
+	(void) reason;
+
+	// Can't fail, there is room for every thread, see edf_reserve()
+	thread->heapNode.key = edf_key(thread);
+	heap_insert(rq, &thread->heapNode);
+}
+
+static uthread_t edf_pick_next(void *rq)
+{
+	struct heap_node *node = heap_pop(rq);
+
+	if (node == NULL) {
+		return NULL;
+	}
+
+	return container_of(node, struct uthread_tcb, heapNode);
+}
+
+static void edf_remove(void *rq, uthread_t thread)
+{
+	heap_remove(rq, &thread->heapNode);
+}
+
+static bool edf_on_tick(void *rq, uthread_t current)
+{
+	struct heap_node *node = heap_min(rq);
+
+	// Keep running unless a ready thread is at least as urgent, in which
+	// case threads with equal deadlines take turns
+	return node != NULL && node->key <= edf_key(current);
+}
+
+static bool edf_on_wake(void *rq, uthread_t thread, uthread_t current)
+{
+	(void) rq;
+
+	// Woken thread runs right away if more urgent than the running one
+	return edf_key(thread) < edf_key(current);
+}
+
+static int edf_reserve(void *rq, unsigned int threads)
+{
+	return heap_reserve(rq, threads);
+}
+
+const struct uthread_policy uthread_policy_edf = {
+	.name = "edf",
+	.init = edf_init,
+	.fini = edf_fini,
+	.enqueue = edf_enqueue,
+	.pick_next = edf_pick_next,
+	.remove = edf_remove,
+	.on_tick = edf_on_tick,
+	.on_wake = edf_on_wake,
+	.reserve = edf_reserve,
+};
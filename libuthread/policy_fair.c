@@ -0,0 +1,322 @@
+#include <stdlib.h>
+
+#include "heap.h"
+#include "policy.h"
+#include "private.h"
+
+/*
+ * Fair-share policy
+ *
+ * Scheduling happens at two levels. Each thread group accumulates a virtual
+ * runtime as its threads run, scaled down by its weight, and groups with ready
+ * threads are kept in a min-heap keyed on it: the group that has received the
+ * least of its share runs next. Within that group, each thread accumulates its
+ * own virtual runtime and the ready thread that has run the least is picked
+ * from the group's own min-heap.
+ *
+ * Threads and groups coming back after a while are brought forward to at most
+ * FAIR_WAKE_CREDIT behind the rest, so that they cannot monopolize the CPU to
+ * catch up. New threads start level with the rest of their group.
+ *
+ * Heaps never have to grow while threads are enqueued: each scheduler's heaps
+ * have room for all of its threads, and each group's heap for all of its
+ * members.
+ */
+#define FAIR_WAKE_CREDIT 5000000ULL	/* 5 ms */
+
+struct fair_rq {
+	struct heap groups;
+	struct uthread_group defaultGroup;
+	uint64_t minVruntime;
+};
+
+/*
+ * fair_floor - Smallest virtual runtime allowed for a thread or group
+ */
+static uint64_t fair_floor(uint64_t minVruntime)
+{
+	return minVruntime > FAIR_WAKE_CREDIT ? minVruntime - FAIR_WAKE_CREDIT : 0;
+}
+
+/*
+ * fair_group - Group a thread is scheduled in
+ */
+static struct uthread_group *fair_group(struct fair_rq *frq, uthread_t thread)
+{
+	return thread->group != NULL ? thread->group : &frq->defaultGroup;
+}
+
+/*
+ * fair_group_init - Initialize group state
+ */
+static void fair_group_init(struct uthread_group *group, unsigned int weight)
+{
+	group->weight = weight;
+	group->members = 0;
+	group->runtime = 0;
+	group->vruntime = group->minVruntime = 0;
+	heap_init(&group->threads);
+}
+
+static void *fair_init(void)
+{
+	struct fair_rq *frq = malloc(sizeof(struct fair_rq));
+	if (frq == NULL) {
+		return NULL;
+	}
+
+	heap_init(&frq->groups);
+	fair_group_init(&frq->defaultGroup, UTHREAD_GROUP_WEIGHT_DEFAULT);
+	frq->minVruntime = 0;
+
+	return frq;
+}
+
+static void fair_fini(void *rq)
+{
+	struct fair_rq *frq = rq;
+
+	heap_fini(&frq->defaultGroup.threads);
+	heap_fini(&frq->groups);
+	free(frq);
+}
+
+/*
+ * fair_charge - Add time run since last charge to a thread and its group
+ */
+static void fair_charge(struct fair_rq *frq, uthread_t thread)
+{
+	struct uthread_group *group = fair_group(frq, thread);
+	uint64_t delta = thread->runtime - thread->charged;
+
+	thread->charged = thread->runtime;
+	thread->vruntime += delta;
+	if (thread->vruntime < fair_floor(group->minVruntime)) {
+		thread->vruntime = fair_floor(group->minVruntime);
+	}
+
+	group->runtime += delta;
+	group->vruntime += delta * UTHREAD_GROUP_WEIGHT_DEFAULT / group->weight;
+
+	// Group's key changes if it is waiting with other ready threads
+	if (group->threads.size > 0) {
+		heap_remove(&frq->groups, &group->heapNode);
+		group->heapNode.key = group->vruntime;
+		heap_insert(&frq->groups, &group->heapNode);
+	}
+}
+
+static void fair_enqueue(void *rq, uthread_t thread, int reason)
+{
+	struct fair_rq *frq = rq;
+	struct uthread_group *group = fair_group(frq, thread);
+
+	if (reason == UTHREAD_ENQUEUE_NEW) {
+		thread->charged = thread->runtime;
+		thread->vruntime = group->minVruntime;
+	} else {
+		fair_charge(frq, thread);
+	}
+
+	if (group->threads.size == 0) {
+		// Group becomes runnable
+		if (group->vruntime < fair_floor(frq->minVruntime)) {
+			group->vruntime = fair_floor(frq->minVruntime);
+		}
+		group->heapNode.key = group->vruntime;
+		heap_insert(&frq->groups, &group->heapNode);
+	}
+
+	thread->heapNode.key = thread->vruntime;
+	heap_insert(&group->threads, &thread->heapNode);
+}
+
+static uthread_t fair_pick_next(void *rq)
+{
+	struct fair_rq *frq = rq;
+	struct heap_node *node = heap_min(&frq->groups);
+
+	if (node == NULL) {
+		return NULL;
+	}
+
+	// Most deserving thread of most deserving group
+	struct uthread_group *group = container_of(node, struct uthread_group, heapNode);
+	node = heap_pop(&group->threads);
+	uthread_t thread = container_of(node, struct uthread_tcb, heapNode);
+
+	if (group->threads.size == 0) {
+		heap_remove(&frq->groups, &group->heapNode);
+	}
+
+	if (thread->vruntime > group->minVruntime) {
+		group->minVruntime = thread->vruntime;
+	}
+	if (group->vruntime > frq->minVruntime) {
+		frq->minVruntime = group->vruntime;
+	}
+
+	return thread;
+}
+
+static void fair_remove(void *rq, uthread_t thread)
+{
+	struct fair_rq *frq = rq;
+	struct uthread_group *group = fair_group(frq, thread);
+
+	heap_remove(&group->threads, &thread->heapNode);
+	if (group->threads.size == 0) {
+		heap_remove(&frq->groups, &group->heapNode);
+	}
+}
+
+static bool fair_on_tick(void *rq, uthread_t current)
+{
+	struct fair_rq *frq = rq;
+	struct uthread_group *group = fair_group(frq, current);
+
+	fair_charge(frq, current);
+
+	struct heap_node *node = heap_min(&frq->groups);
+	if (node == NULL) {
+		return false;
+	}
+
+	// Preempt if another group, or another thread of the same group, is
+	// now behind the running one
+	struct uthread_group *next = container_of(node, struct uthread_group, heapNode);
+	if (next != group) {
+		return next->vruntime < group->vruntime;
+	}
+
+	node = heap_min(&group->threads);
+	return node->key < current->vruntime;
+}
+
+static void fair_on_block(void *rq, uthread_t thread)
+{
+	fair_charge(rq, thread);
+}
+
+static int fair_reserve(void *rq, unsigned int threads)
+{
+	struct fair_rq *frq = rq;
+
+	// At most one group per thread is ready
+	if (heap_reserve(&frq->groups, threads) ||
+	    heap_reserve(&frq->defaultGroup.threads, threads)) {
+		return -1;
+	}
+
+	return 0;
+}
+
+int group_reserve(struct uthread_group *group, unsigned int members)
+{
+	return heap_reserve(&group->threads, members);
+}
+
+const struct uthread_policy uthread_policy_fair = {
+	.name = "fair",
+	.init = fair_init,
+	.fini = fair_fini,
+	.enqueue = fair_enqueue,
+	.pick_next = fair_pick_next,
+	.remove = fair_remove,
+	.on_tick = fair_on_tick,
+	.on_block = fair_on_block,
+	.reserve = fair_reserve,
+};
+
+uthread_group_t uthread_group_create(unsigned int weight)
+{
+	if (weight == 0) {
+		return NULL;
+	}
+
+	preempt_disable();
+	struct uthread_group *group = malloc(sizeof(struct uthread_group));
+	preempt_enable();
+	if (group == NULL) {
+		return NULL;
+	}
+
+	fair_group_init(group, weight);
+
+	return group;
+}
+
+int uthread_group_destroy(uthread_group_t group)
+{
+	if (group == NULL || group->members != 0) {
+		return -1;
+	}
+
+	preempt_disable();
+	heap_fini(&group->threads);
+	free(group);
+	preempt_enable();
+
+	return 0;
+}
+
+int uthread_group_set_weight(uthread_group_t group, unsigned int weight)
+{
+	if (group == NULL || weight == 0) {
+		return -1;
+	}
+
+	preempt_disable();
+	group->weight = weight;
+	preempt_enable();
+
+	return 0;
+}
+
+/*
+ * fair_update_group - Move thread to a new group
+ */
+static void fair_update_group(uthread_t thread, void *arg)
+{
+	struct uthread_group *group = arg;
+
+	if (thread->group != NULL) {
+		thread->group->members--;
+	}
+	if (group != NULL) {
+		group->members++;
+	}
+	thread->group = group;
+
+	// Virtual runtime of old group is meaningless in the new one, it gets
+	// brought level with the new group the next time it is charged
+	thread->vruntime = 0;
+}
+
+int uthread_group_join(uthread_t thread, uthread_group_t group)
+{
+	if (thread == NULL) {
+		return -1;
+	}
+
+	// Room for the thread in its new group, before it can get ready there
+	preempt_disable();
+	int ret = group != NULL ? group_reserve(group, group->members + 1) : 0;
+	preempt_enable();
+	if (ret) {
+		return -1;
+	}
+
+	uthread_update(thread, fair_update_group, group);
+
+	return 0;
+}
+
+uint64_t uthread_group_runtime(uthread_group_t group)
+{
+	if (group == NULL) {
+		return 0;
+	}
+
+	return group->runtime;
+}
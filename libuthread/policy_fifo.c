@@ -0,0 +1,53 @@
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "policy.h"
+#include "private.h"
+
+/*
+ * FIFO policy
+ *
+ * The run queue is a plain queue: threads run in the order they become ready,
+ * whatever the reason.
+ */
+
+static void *fifo_init(void)
+{
+	struct thread_queue *queue = malloc(sizeof(struct thread_queue));
+	if (queue == NULL) {
+		return NULL;
+	}
+
+	thread_queue_init(queue);
+	return queue;
+}
+
+static void fifo_fini(void *rq)
+{
+	free(rq);
+}
+
+static void fifo_enqueue(void *rq, uthread_t thread, int reason)
+{
+	(void) reason;
+	thread_queue_enqueue(rq, thread);
+}
+
+static uthread_t fifo_pick_next(void *rq)
+{
+	return thread_queue_dequeue(rq);
+}
+
+static void fifo_remove(void *rq, uthread_t thread)
+{
+	thread_queue_remove(rq, thread);
+}
+
+const struct uthread_policy uthread_policy_fifo = {
+	.name = "fifo",
+	.init = fifo_init,
+	.fini = fifo_fini,
+	.enqueue = fifo_enqueue,
+	.pick_next = fifo_pick_next,
+	.remove = fifo_remove,
+};
@@ -0,0 +1,59 @@
+#include <stdlib.h>
+
+#include "policy.h"
+#include "private.h"
+
+/*
+ * LIFO policy
+ *
+ * The run queue is a thread queue, linked through the TCBs. Threads that were
+ * just created or woken up are pushed at the front and run first, while their
+ * data is still in cache. Threads that yield or get preempted are enqueued at
+ * the back so that they let every other thread run first.
+ */
+
+static void *lifo_init(void)
+{
+	struct thread_queue *queue = malloc(sizeof(struct thread_queue));
+	if (queue == NULL) {
+		return NULL;
+	}
+
+	thread_queue_init(queue);
+	return queue;
+}
+
+static void lifo_fini(void *rq)
+{
+	free(rq);
+}
+
+static void lifo_enqueue(void *rq, uthread_t thread, int reason)
+{
+	if (reason == UTHREAD_ENQUEUE_YIELD || reason == UTHREAD_ENQUEUE_PREEMPT) {
+		// Append at back
+		thread_queue_enqueue(rq, thread);
+	} else {
+		// Push at front
+		thread_queue_push_front(rq, thread);
+	}
+}
+
+static void lifo_remove(void *rq, uthread_t thread)
+{
+	thread_queue_remove(rq, thread);
+}
+
+static uthread_t lifo_pick_next(void *rq)
+{
+	return thread_queue_dequeue(rq);
+}
+
+const struct uthread_policy uthread_policy_lifo = {
+	.name = "lifo",
+	.init = lifo_init,
+	.fini = lifo_fini,
+	.enqueue = lifo_enqueue,
+	.pick_next = lifo_pick_next,
+	.remove = lifo_remove,
+};
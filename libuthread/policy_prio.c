@@ -0,0 +1,160 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "policy.h"
+#include "private.h"
+
+/*
+ * Priority policy (multi-level feedback queue)
+ *
+ * Ready threads are kept in one FIFO queue per priority level, and bit i of
+ * mask is set when level i is not empty so that the highest priority level can
+ * be found in O(1). A thread preempted at the end of its time slice moves down
+ * one level, up to MLFQ_DEPTH levels below its base priority, and moves back up
+ * one level each time it blocks before the end of its slice. Every
+ * MLFQ_BOOST_TICKS ticks, all threads are reset to their base priority so that
+ * CPU-bound threads cannot be starved forever.
+ */
+#define MLFQ_DEPTH 3
+#define MLFQ_BOOST_TICKS 100
+
+struct prio_rq {
+	struct thread_queue queues[UTHREAD_PRIO_LEVELS];
+	uint32_t mask;
+	unsigned int boostEpoch;
+	unsigned int ticksSinceBoost;
+};
+
+static void prio_fini(void *rq)
+{
+	free(rq);
+}
+
+static void *prio_init(void)
+{
+	struct prio_rq *prq = calloc(1, sizeof(struct prio_rq));
+	if (prq == NULL) {
+		return NULL;
+	}
+
+	for (int prio = 0; prio < UTHREAD_PRIO_LEVELS; prio++) {
+		thread_queue_init(&prq->queues[prio]);
+	}
+
+	return prq;
+}
+
+static void prio_enqueue(void *rq, uthread_t thread, int reason)
+{
+	struct prio_rq *prq = rq;
+
+	// New thread, or thread that missed the last boost while it was blocked
+	if (reason == UTHREAD_ENQUEUE_NEW || reason == UTHREAD_ENQUEUE_REQUEUE ||
+	    thread->boostEpoch != prq->boostEpoch) {
+		thread->prio = thread->basePrio;
+		thread->boostEpoch = prq->boostEpoch;
+	}
+
+	thread_queue_enqueue(&prq->queues[thread->prio], thread);
+	prq->mask |= 1u << thread->prio;
+}
+
+/*
+ * prio_pick_level - Remove oldest thread of a non-empty priority level
+ */
+static uthread_t prio_pick_level(struct prio_rq *prq, int prio)
+{
+	uthread_t thread = thread_queue_dequeue(&prq->queues[prio]);
+
+	if (thread_queue_length(&prq->queues[prio]) == 0) {
+		prq->mask &= ~(1u << prio);
+	}
+
+	return thread;
+}
+
+static uthread_t prio_pick_next(void *rq)
+{
+	struct prio_rq *prq = rq;
+
+	if (prq->mask == 0) {
+		return NULL;
+	}
+
+	// Lowest bit set is the highest priority level
+	return prio_pick_level(prq, __builtin_ctz(prq->mask));
+}
+
+static void prio_remove(void *rq, uthread_t thread)
+{
+	struct prio_rq *prq = rq;
+	struct thread_queue *queue = &prq->queues[thread->prio];
+
+	thread_queue_remove(queue, thread);
+	if (thread_queue_length(queue) == 0) {
+		prq->mask &= ~(1u << thread->prio);
+	}
+}
+
+/*
+ * prio_boost - Reset all threads to their base priority
+ */
+static void prio_boost(struct prio_rq *prq, uthread_t current)
+{
+	// Threads not ready right now are reset when they get ready again
+	prq->boostEpoch++;
+	current->prio = current->basePrio;
+	current->boostEpoch = prq->boostEpoch;
+
+	// Move every ready thread to its base level, which is never below its
+	// current level
+	for (int prio = 0; prio < UTHREAD_PRIO_LEVELS; prio++) {
+		int length = thread_queue_length(&prq->queues[prio]);
+
+		for (int i = 0; i < length; i++) {
+			prio_enqueue(prq, prio_pick_level(prq, prio), UTHREAD_ENQUEUE_WAKE);
+		}
+	}
+}
+
+static bool prio_on_tick(void *rq, uthread_t current)
+{
+	struct prio_rq *prq = rq;
+
+	// Running thread used up its whole time slice
+	int floor = current->basePrio + MLFQ_DEPTH;
+	if (floor > UTHREAD_PRIO_LOWEST) {
+		floor = UTHREAD_PRIO_LOWEST;
+	}
+	if (current->prio < floor) {
+		current->prio++;
+	}
+
+	if (++prq->ticksSinceBoost >= MLFQ_BOOST_TICKS) {
+		prq->ticksSinceBoost = 0;
+		prio_boost(prq, current);
+	}
+
+	return true;
+}
+
+static void prio_on_block(void *rq, uthread_t thread)
+{
+	(void) rq;
+
+	// Blocking before the end of the time slice earns a higher priority
+	if (thread->prio > thread->basePrio) {
+		thread->prio--;
+	}
+}
+
+const struct uthread_policy uthread_policy_prio = {
+	.name = "prio",
+	.init = prio_init,
+	.fini = prio_fini,
+	.enqueue = prio_enqueue,
+	.pick_next = prio_pick_next,
+	.remove = prio_remove,
+	.on_tick = prio_on_tick,
+	.on_block = prio_on_block,
+};
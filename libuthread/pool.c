@@ -0,0 +1,446 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "pool.h"
+#include "private.h"
+#include "uthread.h"
+
+/* Initial number of jobs the queue can hold, doubled whenever it is full */
+#define POOL_JOBS_INIT 64
+
+struct pool_job {
+	uthread_func_t func;
+	void *arg;
+};
+
+/*
+ * Thread waiting on a pool. On the stack of workers, and allocated for threads
+ * waiting for jobs to be done, whose stack may be shared and copied away while
+ * they are switched out
+ */
+struct pool_waiter {
+	struct uthread_tcb *thread;
+	struct pool_waiter *next;
+};
+
+/*
+ * Worker state, on the worker's stack, which the worker's TCB points to while
+ * it runs a job
+ */
+struct pool_worker {
+	struct uthread_pool *pool;
+	struct pool_waiter waiter;
+	bool blocked;
+};
+
+struct uthread_pool {
+	// Jobs not started yet, in a circular buffer
+	struct pool_job *jobs;
+	size_t capacity;
+	size_t head;
+	size_t count;
+
+	// Jobs queued or running, and threads waiting for them to be done
+	size_t pending;
+	struct pool_waiter *waiters;
+
+	// Workers able to take a job, i.e. not blocked in one, and how many
+	// there should be
+	unsigned int active;
+	unsigned int size;
+
+	// Live workers, and workers waiting for a job
+	unsigned int workers;
+	struct pool_waiter *idle;
+
+	// Worker allocated in advance, which takes over from a worker blocked in
+	// a job without allocating anything (NULL if none)
+	struct uthread_tcb *spare;
+	bool refilling;
+
+	bool stopping;
+	struct uthread_tcb *destroyer;
+};
+
+/*
+ * pool_wake_all - Unblock all threads of a waiter list
+ *
+ * Must be called with preemption disabled. Enables preemption.
+ */
+static void pool_wake_all(struct pool_waiter *waiters)
+{
+	preempt_enable();
+
+	while (waiters != NULL) {
+		// Waiter's structure goes away as soon as it runs again
+		struct pool_waiter *next = waiters->next;
+
+		uthread_unblock(waiters->thread);
+		waiters = next;
+	}
+}
+
+static void pool_worker_main(void *arg);
+
+/*
+ * pool_spare_refill - Allocate a spare worker if there is none
+ */
+static void pool_spare_refill(struct uthread_pool *pool)
+{
+	preempt_disable();
+	if (pool->spare != NULL || pool->refilling || pool->stopping) {
+		preempt_enable();
+		return;
+	}
+	pool->refilling = true;
+	preempt_enable();
+
+	// Spare stays blocked until it is needed. Without one, a worker is
+	// created on the next submission instead
+	struct uthread_tcb *spare = uthread_new(pool_worker_main, pool);
+
+	preempt_disable();
+	pool->refilling = false;
+	if (spare != NULL && pool->stopping) {
+		// Pool got destroyed meanwhile, spare starts only to exit
+		pool->workers++;
+		preempt_enable();
+		uthread_unblock(spare);
+		return;
+	}
+	pool->spare = spare;
+	preempt_enable();
+}
+
+/*
+ * pool_worker_done - Account for the end of a job
+ * @worker: Worker that ran the job
+ *
+ * Must be called with preemption disabled.
+ *
+ * Return: true if the worker should exit, as there are enough workers without it
+ */
+static bool pool_worker_done(struct pool_worker *worker)
+{
+	struct uthread_pool *pool = worker->pool;
+
+	if (--pool->pending == 0 && pool->waiters != NULL) {
+		struct pool_waiter *waiters = pool->waiters;
+
+		pool->waiters = NULL;
+		pool_wake_all(waiters);
+		preempt_disable();
+	}
+
+	if (!worker->blocked) {
+		return false;
+	}
+
+	// Another worker took over while the job was blocked
+	worker->blocked = false;
+	if (pool->active >= pool->size) {
+		return true;
+	}
+	pool->active++;
+
+	return false;
+}
+
+/*
+ * pool_worker_main - Entry point of worker threads
+ */
+static void pool_worker_main(void *arg)
+{
+	struct pool_worker self;
+	struct uthread_tcb *thread = uthread_current();
+
+	self.pool = arg;
+	self.waiter.thread = thread;
+	self.blocked = false;
+
+	struct uthread_pool *pool = self.pool;
+
+	// Spare worker that just took over, the next one is prepared now that
+	// allocations are possible
+	pool_spare_refill(pool);
+
+	preempt_disable();
+	for (;;) {
+		if (pool->count == 0) {
+			if (pool->stopping) {
+				break;
+			}
+
+			// Wait for a job (preemption is enabled again on resume)
+			self.waiter.next = pool->idle;
+			pool->idle = &self.waiter;
+			uthread_block();
+			preempt_disable();
+			continue;
+		}
+
+		struct pool_job job = pool->jobs[pool->head];
+		pool->head = (pool->head + 1) % pool->capacity;
+		pool->count--;
+
+		// Blocking in the job is noticed through the TCB, see
+		// pool_worker_block()
+		thread->poolWorker = &self;
+		preempt_enable();
+
+		job.func(job.arg);
+
+		// Memory the job allocated with uthread_alloc() goes with it
+		preempt_disable();
+		thread->poolWorker = NULL;
+		uthread_arena_release();
+
+		if (pool_worker_done(&self)) {
+			break;
+		}
+	}
+
+	// Last worker to go lets the pool be deallocated
+	if (--pool->workers == 0 && pool->destroyer != NULL) {
+		struct uthread_tcb *destroyer = pool->destroyer;
+
+		pool->destroyer = NULL;
+		preempt_enable();
+		uthread_unblock(destroyer);
+		return;
+	}
+
+	preempt_enable();
+}
+
+struct uthread_tcb *pool_worker_block(struct pool_worker *worker)
+{
+	struct uthread_pool *pool = worker->pool;
+
+	// Already accounted for if the job blocks several times
+	if (worker->blocked) {
+		return NULL;
+	}
+
+	worker->blocked = true;
+	pool->active--;
+
+	// Spare only needed if there is work waiting
+	if (pool->count == 0 || pool->spare == NULL || pool->active >= pool->size) {
+		return NULL;
+	}
+
+	struct uthread_tcb *spare = pool->spare;
+
+	pool->spare = NULL;
+	pool->workers++;
+	pool->active++;
+
+	return spare;
+}
+
+uthread_pool_t uthread_pool_create(unsigned int workers)
+{
+	if (workers == 0) {
+		return NULL;
+	}
+
+	preempt_disable();
+	struct uthread_pool *pool = malloc(sizeof(struct uthread_pool));
+	struct pool_job *jobs = malloc(POOL_JOBS_INIT * sizeof(struct pool_job));
+	preempt_enable();
+	if (pool == NULL || jobs == NULL) {
+		preempt_disable();
+		free(jobs);
+		free(pool);
+		preempt_enable();
+		return NULL;
+	}
+
+	pool->jobs = jobs;
+	pool->capacity = POOL_JOBS_INIT;
+	pool->head = pool->count = 0;
+	pool->pending = 0;
+	pool->waiters = NULL;
+	pool->active = pool->workers = 0;
+	pool->size = workers;
+	pool->idle = NULL;
+	pool->spare = NULL;
+	pool->refilling = false;
+	pool->stopping = false;
+	pool->destroyer = NULL;
+
+	// Spare is created last, once the pool is known to be usable
+	for (unsigned int i = 0; i < workers; i++) {
+		if (uthread_create(pool_worker_main, pool)) {
+			uthread_pool_destroy(pool);
+			return NULL;
+		}
+
+		preempt_disable();
+		pool->workers++;
+		pool->active++;
+		preempt_enable();
+	}
+	pool_spare_refill(pool);
+
+	return pool;
+}
+
+/*
+ * pool_jobs_grow - Double the capacity of the job queue
+ *
+ * Must be called with preemption disabled.
+ *
+ * Return: 0 if the queue has room for a new job, -1 otherwise
+ */
+static int pool_jobs_grow(struct uthread_pool *pool)
+{
+	if (pool->capacity > SIZE_MAX / 2 / sizeof(struct pool_job)) {
+		return -1;
+	}
+
+	struct pool_job *jobs = malloc(2 * pool->capacity * sizeof(struct pool_job));
+	if (jobs == NULL) {
+		return -1;
+	}
+
+	// Jobs are moved back in order at the start of the new buffer
+	for (size_t i = 0; i < pool->count; i++) {
+		jobs[i] = pool->jobs[(pool->head + i) % pool->capacity];
+	}
+
+	free(pool->jobs);
+	pool->jobs = jobs;
+	pool->capacity *= 2;
+	pool->head = 0;
+
+	return 0;
+}
+
+int uthread_pool_submit(uthread_pool_t pool, uthread_func_t func, void *arg)
+{
+	if (pool == NULL || func == NULL) {
+		return -1;
+	}
+
+	preempt_disable();
+
+	if (pool->stopping ||
+	    (pool->count == pool->capacity && pool_jobs_grow(pool))) {
+		preempt_enable();
+		return -1;
+	}
+
+	size_t tail = (pool->head + pool->count) % pool->capacity;
+	pool->jobs[tail].func = func;
+	pool->jobs[tail].arg = arg;
+	pool->count++;
+	pool->pending++;
+
+	// Hand job to an idle worker, the most recent one as its stack is more
+	// likely to still be in cache. Otherwise, put the spare to work if
+	// workers are missing, or leave the job queued for a busy worker
+	struct uthread_tcb *worker = NULL;
+	if (pool->idle != NULL) {
+		worker = pool->idle->thread;
+		pool->idle = pool->idle->next;
+	} else if (pool->active < pool->size && pool->spare != NULL) {
+		worker = pool->spare;
+		pool->spare = NULL;
+		pool->workers++;
+		pool->active++;
+	}
+
+	preempt_enable();
+
+	if (worker != NULL) {
+		uthread_unblock(worker);
+	}
+
+	return 0;
+}
+
+int uthread_pool_wait(uthread_pool_t pool)
+{
+	if (pool == NULL) {
+		return -1;
+	}
+
+	preempt_disable();
+	if (pool->pending == 0) {
+		preempt_enable();
+		return 0;
+	}
+
+	struct pool_waiter *self = malloc(sizeof(struct pool_waiter));
+	if (self == NULL) {
+		preempt_enable();
+		return -1;
+	}
+
+	// Woken up once the last job is done (preemption is enabled again on
+	// resume)
+	self->thread = uthread_current();
+	self->next = pool->waiters;
+	pool->waiters = self;
+	uthread_block();
+
+	preempt_disable();
+	free(self);
+	preempt_enable();
+
+	return 0;
+}
+
+int uthread_pool_destroy(uthread_pool_t pool)
+{
+	if (pool == NULL) {
+		return -1;
+	}
+
+	if (uthread_pool_wait(pool)) {
+		return -1;
+	}
+
+	// Idle workers, and the spare if it never ran, exit as soon as they run
+	preempt_disable();
+	pool->stopping = true;
+
+	struct uthread_tcb *spare = pool->spare;
+	if (spare != NULL) {
+		pool->spare = NULL;
+		pool->workers++;
+	}
+
+	struct pool_waiter *idle = pool->idle;
+	pool->idle = NULL;
+
+	bool wait = pool->workers > 0;
+	if (wait) {
+		pool->destroyer = uthread_current();
+	}
+
+	pool_wake_all(idle);
+	if (spare != NULL) {
+		uthread_unblock(spare);
+	}
+
+	if (wait) {
+		preempt_disable();
+		if (pool->destroyer != NULL) {
+			uthread_block();
+		} else {
+			preempt_enable();
+		}
+	}
+
+	preempt_disable();
+	free(pool->jobs);
+	free(pool);
+	preempt_enable();
+
+	return 0;
+}
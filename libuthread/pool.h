@@ -0,0 +1,68 @@
+#ifndef _POOL_H
+#define _POOL_H
+
+#include "uthread.h"
+
+/*
+ * uthread_pool_t - Thread pool type
+ *
+ * A thread pool runs short jobs on a set of long-lived worker threads, which
+ * take jobs from a queue one after the other. Submitting a job only costs
+ * adding it to the queue, instead of creating and destroying a thread.
+ *
+ * A job that blocks (e.g., on a semaphore) keeps the stack of the worker
+ * running it until it returns. Meanwhile, another worker takes over so that
+ * the rest of the queue is still drained by as many workers as the pool was
+ * created with. Extra workers exit once the jobs that blocked are done.
+ *
+ * Jobs must return rather than call uthread_exit(). Memory a job allocated with
+ * uthread_alloc() is released once it returns.
+ */
+typedef struct uthread_pool *uthread_pool_t;
+
+/*
+ * uthread_pool_create - Create a thread pool
+ * @workers: Number of jobs run concurrently
+ *
+ * Return: Pointer to new pool. NULL if @workers is 0 or in case of failure
+ * (e.g., memory allocation, context creation).
+ */
+uthread_pool_t uthread_pool_create(unsigned int workers);
+
+/*
+ * uthread_pool_submit - Queue a job
+ * @pool: Pool to run the job
+ * @func: Function of the job
+ * @arg: Argument to be passed to @func
+ *
+ * Jobs are started in the order they are submitted.
+ *
+ * Return: -1 if @pool or @func are NULL, if @pool is being destroyed, or in
+ * case of failure when allocating memory. 0 if the job was queued.
+ */
+int uthread_pool_submit(uthread_pool_t pool, uthread_func_t func, void *arg);
+
+/*
+ * uthread_pool_wait - Wait for all jobs of a pool to be done
+ * @pool: Pool to wait for
+ *
+ * The calling thread is blocked until every job submitted so far, and every job
+ * submitted while waiting, has returned. It must not be a job of @pool.
+ *
+ * Return: -1 if @pool is NULL, or in case of failure when allocating memory. 0
+ * once @pool has no job left.
+ */
+int uthread_pool_wait(uthread_pool_t pool);
+
+/*
+ * uthread_pool_destroy - Deallocate a thread pool
+ * @pool: Pool to deallocate
+ *
+ * Wait for all jobs of @pool to be done, then for its workers to exit.
+ *
+ * Return: -1 if @pool is NULL, or in case of failure when allocating memory
+ * (@pool is left as it was). 0 if @pool was successfully destroyed.
+ */
+int uthread_pool_destroy(uthread_pool_t pool);
+
+#endif /* _POOL_H */
@@ -1,76 +1,195 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "private.h"
 #include "uthread.h"
 
+/* Older C libraries don't name the thread ID member of struct sigevent */
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
 /*
- * Frequency of preemption
- * 100Hz is 100 times per second
+ * Action for virtual alarms, shared by the schedulers of all kernel threads:
+ * installed by the first one that starts preemption, and the action it
+ * replaced restored by the last one that stops it
  */
-#define HZ 100
+static pthread_mutex_t actionLock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int actionUsers;
+static struct sigaction oldAction;
 
-static struct itimerval timer;
-static struct sigaction sa;
+/* Signal masked by preempt_disable(), set up once for all */
 static sigset_t block;
+static bool blockReady;
 
 /*
 	Install a signal handler that receives alarm signals (type SIGVTALRM)
-	Configure a time which will fire an alarm (through a SIGVTALRM signal) 100 Hz
+	Create a timer on the CPU time of the calling kernel thread, which fires an
+	alarm (through a SIGVTALRM signal sent to that same thread) each time the
+	running thread has used up its time slice
 */
 
 // Timer interrupt handler
 void handler(int signum) {
+	// Threads switched to from here may change errno, which the interrupted
+	// thread gets back once it runs again
+	int savedErrno = errno;
+
 	if (signum == SIGVTALRM) {
-		uthread_yield();
+		uthread_tick();
 	}
+
+	errno = savedErrno;
 }
 
 void preempt_disable(void)
 {
-	sigprocmask(SIG_BLOCK, &block, NULL);
+	pthread_sigmask(SIG_BLOCK, &block, NULL);
 }
 
 void preempt_enable(void)
 {
-	sigprocmask(SIG_UNBLOCK, &block, NULL);
+	pthread_sigmask(SIG_UNBLOCK, &block, NULL);
 
 }
 
-void preempt_start(bool preempt)
+/*
+ * preempt_action_get - Install alarm handler, unless already installed
+ *
+ * Return: 0 in case of success, -1 if installing it failed
+ */
+static int preempt_action_get(void)
 {
-	if (preempt) {
+	int ret = 0;
+
+	pthread_mutex_lock(&actionLock);
+	if (actionUsers == 0) {
 		// Creating the structure for new action and forcing current running thread to yield
+		struct sigaction sa;
 		sa.sa_handler = handler;
 		sigemptyset(&sa.sa_mask);
 		sa.sa_flags = 0;
+		ret = sigaction(SIGVTALRM, &sa, &oldAction);
+	}
+	if (ret == 0) {
+		actionUsers++;
+	}
+	pthread_mutex_unlock(&actionLock);
+
+	return ret;
+}
+
+/*
+ * preempt_action_put - Restore previous alarm action, once no scheduler uses it
+ */
+static void preempt_action_put(void)
+{
+	pthread_mutex_lock(&actionLock);
+	if (--actionUsers == 0) {
+		// Discard any alarm still pending, then restore action previously
+		// associated to virtual alarms
+		struct sigaction sa;
+		sa.sa_handler = SIG_IGN;
+		sigemptyset(&sa.sa_mask);
+		sa.sa_flags = 0;
 		sigaction(SIGVTALRM, &sa, NULL);
+		sigaction(SIGVTALRM, &oldAction, NULL);
+	}
+	pthread_mutex_unlock(&actionLock);
+}
+
+void preempt_start(struct preempt_timer *timer, bool preempt)
+{
+	pthread_mutex_lock(&actionLock);
+	if (!blockReady) {
+		sigemptyset(&block);
+		sigaddset(&block, SIGVTALRM);
+		blockReady = true;
+	}
+	pthread_mutex_unlock(&actionLock);
+
+	timer->enabled = false;
+	timer->armedQuantum = 0;
+	timer->periodStart = 0;
+
+	if (preempt) {
+		if (preempt_action_get()) {
+			perror("sigaction");
+			return;
+		}
+
+		// Timer measures CPU time of this kernel thread only, and signals it
+		// (not any other thread of the process) when it expires
+		struct sigevent sev;
+		memset(&sev, 0, sizeof(sev));
+		sev.sigev_notify = SIGEV_THREAD_ID;
+		sev.sigev_signo = SIGVTALRM;
+		sev.sigev_notify_thread_id = gettid();
+
+		if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &timer->timer)) {
+			perror("timer_create");
+			preempt_action_put();
+			return;
+		}
+
+		// Timer is only armed once a time slice is set
+		timer->enabled = true;
+	}
+}
 
-		// Setting an alarm/timer
-		timer.it_value.tv_usec = 1000000 / HZ;
-		timer.it_value.tv_sec = 0;
-		timer.it_interval = timer.it_value;
+void preempt_set_quantum(struct preempt_timer *timer, unsigned int quantum,
+			 bool restart)
+{
+	if (!timer->enabled ||
+	    (quantum == timer->armedQuantum && (!restart || quantum == 0))) {
+		// Nothing to change, save a system call
+		return;
+	}
 
-		// Begin timer
-		// ITIMER_VIRTUAL has value that is decremented when process is running
-		// SIGVTALRM signal is generated for process when timer expires
-		setitimer(ITIMER_VIRTUAL, &timer, NULL);
+	// Enough left of the current period to make a time slice
+	if (quantum == timer->armedQuantum &&
+	    (uthread_clock() - timer->periodStart) / 1000 <= quantum / 2) {
+		return;
 	}
+
+	// Periodic timer, or disarmed timer if quantum is 0
+	struct itimerspec its;
+	its.it_value.tv_sec = quantum / 1000000;
+	its.it_value.tv_nsec = (quantum % 1000000) * 1000;
+	its.it_interval = its.it_value;
+
+	timer_settime(timer->timer, 0, &its, NULL);
+	timer->armedQuantum = quantum;
+	timer->periodStart = uthread_clock();
+}
+
+void preempt_period_start(struct preempt_timer *timer)
+{
+	timer->periodStart = uthread_clock();
 }
 
-void preempt_stop(void)
+void preempt_stop(struct preempt_timer *timer)
 {
-	// Restores previous timer 
-	setitimer(ITIMER_VIRTUAL, &timer, NULL);
-
-	// Use SIG_DFL to terminate the process since it restores default behavior
-	sa.sa_handler = SIG_DFL;
-	sa.sa_flags = 0;
-	sigemptyset(&sa.sa_mask);
-	sigaction(SIGVTALRM, &sa, NULL);
+	if (!timer->enabled) {
+		return;
+	}
+
+	// Delete timer, which also disarms it. An alarm it already sent is
+	// ignored by the handler, as no thread is running anymore
+	timer_delete(timer->timer);
+	timer->enabled = false;
+	timer->armedQuantum = 0;
+
+	preempt_action_put();
 }
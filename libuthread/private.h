@@ -10,8 +10,15 @@
 /**
  * Private context API
  */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
 #include <ucontext.h>
 
+#include "heap.h"
+#include "tqueue.h"
 #include "uthread.h"
 
 /*
@@ -26,6 +33,9 @@
  */
 typedef ucontext_t uthread_ctx_t;
 
+/* Size of the stack for a thread (in bytes) */
+#define UTHREAD_STACK_SIZE 32768
+
 /*
  * uthread_ctx_switch - Switch between two execution contexts
  * @prev: Pointer to the execution context structure in which to save the
@@ -35,56 +45,412 @@ typedef ucontext_t uthread_ctx_t;
 void uthread_ctx_switch(uthread_ctx_t *prev, uthread_ctx_t *next);
 
 /*
- * uthread_ctx_alloc_stack - Allocate stack segment
+ * uthread_ctx_init - Initialize a thread's execution context
+ * @uctx: Pointer to thread context to initialize
+ * @top_of_stack: Pointer to the top of a valid stack segment of
+ *	UTHREAD_STACK_SIZE bytes
+ * @func: Function to be executed by the thread
+ * @arg: Argument to pass to the thread
  *
- * Return: Pointer to the top of a valid stack segment, or NULL in case of
- * failure
- */
-void *uthread_ctx_alloc_stack(void);
-
-/*
- * uthread_ctx_destroy_stack - Deallocate stack segment
- * @top_of_stack: Address of stack to deallocate
+ * Return: 0 if @uctx was properly initialized, or -1 in case of failure
  */
-void uthread_ctx_destroy_stack(void *top_of_stack);
+int uthread_ctx_init(uthread_ctx_t *uctx, void *top_of_stack,
+					 uthread_func_t func, void *arg);
 
 /*
- * uthread_ctx_init - Initialize a thread's execution context
+ * uthread_ctx_init_from - Initialize a thread's execution context from another
  * @uctx: Pointer to thread context to initialize
- * @top_of_stack: Pointer to the top of a valid stack segment, as allocated by
- *	uthread_ctx_alloc_stack()
+ * @model: Pointer to a context already initialized with uthread_ctx_init()
+ * @top_of_stack: Pointer to the top of a valid stack segment of
+ *	UTHREAD_STACK_SIZE bytes
  * @func: Function to be executed by the thread
  * @arg: Argument to pass to the thread
  *
+ * Same as uthread_ctx_init(), but cheaper when initializing many contexts at
+ * once: the state that is not specific to the thread is copied from @model.
+ *
  * Return: 0 if @uctx was properly initialized, or -1 in case of failure
  */
-int uthread_ctx_init(uthread_ctx_t *uctx, void *top_of_stack,
-					 uthread_func_t func, void *arg);
+int uthread_ctx_init_from(uthread_ctx_t *uctx, const uthread_ctx_t *model,
+			  void *top_of_stack, uthread_func_t func, void *arg);
+
+/*
+ * uthread_ctx_stack_pointer - Get stack pointer saved in a context
+ * @uctx: Pointer to a context saved by uthread_ctx_switch()
+ *
+ * Return: Lowest address of the stack in use when the context was saved, or
+ * NULL if this is not supported on the current architecture
+ */
+void *uthread_ctx_stack_pointer(const uthread_ctx_t *uctx);
+
+
+/**
+ * Private stack usage API
+ */
+
+/*
+ * stack_usage_start - Reset stack usage measures
+ * @enable: Measure stack usage if true
+ */
+void stack_usage_start(bool enable);
+
+/*
+ * stack_usage_enabled - Check if stack usage is measured
+ *
+ * Return: true if stacks should be filled and measured
+ */
+bool stack_usage_enabled(void);
+
+/*
+ * stack_usage_fill - Fill a new stack with the pattern used for measures
+ * @stack: Bottom of stack of UTHREAD_STACK_SIZE bytes
+ */
+void stack_usage_fill(void *stack);
+
+/*
+ * stack_usage_record - Measure usage of a thread's stack
+ * @func: Entry function of the thread
+ * @stack: Bottom of stack of UTHREAD_STACK_SIZE bytes, filled with
+ *	stack_usage_fill() before the thread started
+ */
+void stack_usage_record(uthread_func_t func, const void *stack);
+
+
+/**
+ * Private shared stack API
+ */
+
+/*
+ * Size of the stack shared by threads created with uthread_create_shared(),
+ * which get as much stack as the other threads
+ */
+#define UTHREAD_SHARED_STACK_SIZE UTHREAD_STACK_SIZE
+
+/*
+ * shared_stack_init - Allocate the shared stack
+ *
+ * Does nothing if it is already allocated.
+ *
+ * Return: 0 if the shared stack is ready to use, -1 in case of failure or if
+ * this is not supported on the current architecture
+ */
+int shared_stack_init(void);
+
+/*
+ * shared_stack_fini - Deallocate the shared stack
+ */
+void shared_stack_fini(void);
+
+/*
+ * shared_stack_switch - Switch to a thread running on the shared stack
+ * @prev: Pointer to the context in which to save the currently running thread
+ * @next: TCB of thread to resume
+ *
+ * The stack of the thread that last ran on the shared stack is copied out of
+ * it, and the one of @next copied in, unless they are the same thread. A new
+ * thread gets its context initialized on the shared stack.
+ */
+void shared_stack_switch(uthread_ctx_t *prev, struct uthread_tcb *next);
+
+/*
+ * shared_stack_release - Forget a thread's stack before it is deallocated
+ * @thread: TCB of thread created with uthread_create_shared()
+ */
+void shared_stack_release(struct uthread_tcb *thread);
+
+
+/**
+ * Private inbox API
+ */
+
+/*
+ * inbox_node - Link of an item in an inbox
+ */
+struct inbox_node {
+	_Atomic(struct inbox_node *) next;
+};
+
+/*
+ * inbox - Lock-free queue of items pushed by any kernel thread, or signal
+ * handler, and popped by a single consumer
+ */
+struct inbox {
+	_Atomic(struct inbox_node *) head;
+	struct inbox_node *tail;
+	struct inbox_node stub;
+};
+
+/*
+ * inbox_init - Initialize an empty inbox
+ * @inbox: Inbox to initialize
+ */
+void inbox_init(struct inbox *inbox);
+
+/*
+ * inbox_push - Add an item to an inbox
+ * @inbox: Inbox to add to
+ * @node: Link of the item
+ *
+ * Can be called from any kernel thread, or from a signal handler: it takes no
+ * lock and makes no allocation.
+ */
+void inbox_push(struct inbox *inbox, struct inbox_node *node);
+
+/*
+ * inbox_pop - Take the oldest item from an inbox
+ * @inbox: Inbox to take from
+ *
+ * Must only be called by the inbox's consumer.
+ *
+ * Return: Link of the oldest item, or NULL if none can be taken right now
+ */
+struct inbox_node *inbox_pop(struct inbox *inbox);
+
+/*
+ * inbox_empty - Check if an inbox is empty
+ * @inbox: Inbox to check
+ *
+ * Must only be called by the inbox's consumer.
+ *
+ * Return: true if there is nothing to pop, not even an item being pushed
+ */
+bool inbox_empty(struct inbox *inbox);
+
+
+/**
+ * Private scheduler API
+ */
+
+/*
+ * sched_create - Create a scheduler
+ * @keepalive: Keep running once it has no thread left, until stopped
+ *
+ * Return: Pointer to the new scheduler, or NULL in case of failure when
+ * allocating it or creating its event counter
+ */
+struct uthread_sched *sched_create(bool keepalive);
+
+/*
+ * sched_destroy - Deallocate a scheduler
+ * @sched: Scheduler to deallocate, which must not be running
+ *
+ * Threads requested but not created yet are dropped.
+ */
+void sched_destroy(struct uthread_sched *sched);
+
+/*
+ * sched_kick - Wake scheduler up if it is sleeping in sched_poll()
+ * @sched: Scheduler to wake up
+ *
+ * Can be called from any kernel thread, or from a signal handler.
+ */
+void sched_kick(struct uthread_sched *sched);
+
+/*
+ * sched_poll - Check for threads whose file descriptor became ready
+ * @sched: Scheduler of the calling kernel thread
+ * @block: Sleep until something happens, instead of only checking
+ * @threads: Array receiving the threads, see uthread_io_wait()
+ * @max: Size of @threads
+ *
+ * A scheduler sleeping in this function is woken up by sched_kick(). It
+ * doesn't sleep if its inboxes are not empty, or if it was stopped.
+ *
+ * Return: Number of threads put in @threads
+ */
+int sched_poll(struct uthread_sched *sched, bool block,
+	       struct uthread_tcb **threads, int max);
+
+/*
+ * sched_spawn_pop - Take the oldest thread creation request
+ * @sched: Scheduler of the calling kernel thread
+ * @func: Address where the function of the thread is received
+ * @arg: Address where the argument of the thread is received
+ *
+ * Must be called with preemption disabled.
+ *
+ * Return: true if a request was taken, false if there is none right now
+ */
+bool sched_spawn_pop(struct uthread_sched *sched, uthread_func_t *func, void **arg);
+
+
+/**
+ * Private placement API
+ */
+
+/*
+ * affinity_start - Pin the scheduler's kernel thread
+ * @cpus: CPUs to run on, in the kernel's list format (e.g. "0-3,8"), or NULL
+ * @node: NUMA node to run on and allocate memory from, or -1
+ *
+ * If @cpus is NULL, the kernel thread runs on the CPUs of @node, if any.
+ *
+ * Return: 0 in case of success, -1 if @cpus or @node are invalid or in case of
+ * failure from the system
+ */
+int affinity_start(const char *cpus, int node);
+
+/*
+ * affinity_stop - Restore placement of the scheduler's kernel thread
+ */
+void affinity_stop(void);
 
+/*
+ * affinity_bind - Ask for memory to be placed on a NUMA node
+ * @addr: Start of memory, aligned to a page
+ * @len: Length of memory
+ * @node: NUMA node, or -1 to do nothing
+ */
+void affinity_bind(void *addr, size_t len, int node);
+
+
+/**
+ * Private arena API
+ */
+
+struct arena_chunk;
+
+/*
+ * arena - Memory of a thread, released all at once
+ * @chunks: Chunks allocations are taken from, the current one first
+ * @last: Oldest chunk, where the list can be spliced into a cache
+ * @count: Number of chunks
+ * @large: Allocations too large for a chunk, in chunks of their own
+ * @next: Free memory left in the current chunk
+ * @end: End of the current chunk
+ */
+struct arena {
+	struct arena_chunk *chunks;
+	struct arena_chunk *last;
+	size_t count;
+	struct arena_chunk *large;
+	char *next;
+	char *end;
+};
+
+/*
+ * arena_cache - Chunks released by arenas, kept for the next ones
+ * @chunks: List of chunks
+ * @count: Number of chunks
+ */
+struct arena_cache {
+	struct arena_chunk *chunks;
+	size_t count;
+};
+
+/*
+ * arena_alloc - Allocate memory from an arena
+ * @arena: Arena of the running thread
+ * @cache: Cache of its scheduler, where new chunks are taken from first
+ * @size: Size in bytes
+ *
+ * Only the running thread's own memory is touched, unless a new chunk is
+ * needed, which is then taken with preemption disabled.
+ *
+ * Return: Pointer to memory aligned for any type, or NULL in case of failure
+ */
+void *arena_alloc(struct arena *arena, struct arena_cache *cache, size_t size);
+
+/*
+ * arena_release - Release all memory of an arena
+ * @arena: Arena to empty
+ * @cache: Cache of the scheduler, which gets the chunks back
+ *
+ * Must be called with preemption disabled. Unless the cache is full, chunks go
+ * back to it at once, whatever their number.
+ */
+void arena_release(struct arena *arena, struct arena_cache *cache);
+
+/*
+ * arena_cache_fini - Deallocate all chunks of a cache
+ * @cache: Cache to empty
+ */
+void arena_cache_fini(struct arena_cache *cache);
+
+
+/**
+ * Private thread pool API
+ */
+
+struct pool_worker;
+
+/*
+ * pool_worker_block - Account for a pool worker blocking in a job
+ * @worker: State of the worker, from the TCB of the running thread
+ *
+ * Called with preemption disabled by the thread that is about to block.
+ *
+ * Return: TCB of a blocked worker to make ready, which takes over the pool's
+ * remaining jobs, or NULL if none is needed
+ */
+struct uthread_tcb *pool_worker_block(struct pool_worker *worker);
 
 /**
  * Private preemption API
  */
 
+/*
+ * preempt_timer - Preemption timer of a scheduler
+ * @enabled: Whether preemption is enabled
+ * @timer: Timer on the CPU time of the scheduler's kernel thread
+ * @armedQuantum: Time slice the timer is set to, 0 if disarmed
+ * @periodStart: When the timer's current period started, on the scheduler's
+ *	clock
+ */
+struct preempt_timer {
+	bool enabled;
+	timer_t timer;
+	unsigned int armedQuantum;
+	uint64_t periodStart;
+};
+
 /*
  * preempt_start - Start thread preemption
+ * @timer: Timer of the scheduler of the calling kernel thread
  * @preempt: Enable preemption if true
  *
- * Configure a timer that must fire a virtual alarm at a frequency of 100 Hz and
- * setup a timer handler that forcefully yields the currently running thread.
+ * Create a timer on the CPU time of the calling kernel thread, and setup a
+ * timer handler that calls uthread_tick(). The timer only starts firing once
+ * preempt_set_quantum() is called. The handler is shared by the schedulers of
+ * all kernel threads.
+ *
+ * If @preempt is false, don't start preemption; preempt_set_quantum() should
+ * then be ineffective.
+ */
+void preempt_start(struct preempt_timer *timer, bool preempt);
+
+/*
+ * preempt_set_quantum - Set length of time slices
+ * @timer: Timer of the scheduler of the calling kernel thread
+ * @quantum: Time between two virtual alarms (in microseconds), or 0 to stop
+ *	the timer
+ * @restart: Start a new period even if @quantum is the current one, unless at
+ *	least half of the current period is left
+ *
+ * The timer keeps firing periodically until the next call. Unless @restart is
+ * true, setting the same quantum as the current one does nothing, so that the
+ * timer is not reset. Restarting costs a system call, which a thread switched
+ * to early in a period, e.g. right after a tick, does without.
+ */
+void preempt_set_quantum(struct preempt_timer *timer, unsigned int quantum,
+			 bool restart);
+
+/*
+ * preempt_period_start - Note that the timer started a new period
+ * @timer: Timer of the scheduler of the calling kernel thread
  *
- * If @preempt is false, don't start preemption; all the other functions from
- * the preemption API should then be ineffective.
+ * Called at each tick, as the periodic timer reloads when it fires.
  */
-void preempt_start(bool preempt);
+void preempt_period_start(struct preempt_timer *timer);
 
 /*
  * preempt_stop - Stop thread preemption
+ * @timer: Timer of the scheduler of the calling kernel thread
  *
- * Restore previous timer configuration, and previous action associated to
- * virtual alarm signals.
+ * Delete the timer, and restore the action previously associated to virtual
+ * alarm signals once no other scheduler uses preemption.
  */
-void preempt_stop(void);
+void preempt_stop(struct preempt_timer *timer);
 
 /*
  * preempt_enable - Enable preemption
@@ -101,11 +467,222 @@ void preempt_disable(void);
  * Private uthread API
  */
 
+/*
+ * uthread_group - Thread group
+ *
+ * Under the fair-share policy, groups get a share of CPU time proportional to
+ * their weight, which their threads then share equally.
+ */
+struct uthread_group {
+	unsigned int weight;
+	unsigned int members;
+	uint64_t runtime;
+
+	// Fair-share policy state: group's virtual runtime, smallest virtual
+	// runtime of its threads, and its ready threads
+	uint64_t vruntime;
+	uint64_t minVruntime;
+	struct heap threads;
+	struct heap_node heapNode;
+};
+
+/*
+ * group_reserve - Make room for the ready threads of a group
+ * @members: Number of threads the group has
+ *
+ * Must be called with preemption disabled.
+ *
+ * Return: -1 in case of memory allocation error, 0 otherwise
+ */
+int group_reserve(struct uthread_group *group, unsigned int members);
+
+enum State {RUNNING, READY, BLOCKED, EXITED};
+typedef enum State state_t;
+
+/* Size of a cache line (in bytes) */
+#define UTHREAD_CACHE_LINE 64
+
+/*
+ * uthread_tls_slot - Thread-local value for a key
+ *
+ * A value only belongs to the key it was set for if the key's generation hasn't
+ * changed since, otherwise it was set for a key since deleted, and reads NULL.
+ */
+struct uthread_tls_slot {
+	void* value;
+	unsigned int generation;
+};
+
+struct generator;
+
 /*
  * uthread_tcb - Internal representation of threads called TCB (Thread Control
  * Block)
+ *
+ * Fields are laid out by how often they are used: the first cache line holds
+ * what every switch and queue operation touches, the second one the rest of
+ * the scheduling state, then comes the execution context, and last the fields
+ * only used occasionally. The TCB is stored right above its thread's stack.
  */
-struct uthread_tcb;
+struct uthread_tcb {
+	// Hot: state, policy's position in queues and its key, and time slice.
+	// The queue link is the run queue while ready, a waiting list while
+	// blocked, or the exited queue once exited
+	_Alignas(UTHREAD_CACHE_LINE) state_t state;
+	int prio;
+	QUEUE_LINK(struct uthread_tcb) queueLink;
+	struct heap_node heapNode;
+	uint64_t sliceStart;
+
+	// Time spent running (in ns)
+	uint64_t runtime;
+
+	// Length of time slices (in microseconds), 0 for the scheduler's default
+	unsigned int quantum;
+
+	// Adaptive time slices: length picked from past behavior (0 until known),
+	// whether the thread was counted as interactive when it became ready,
+	// runtime when the current burst started, and average length of bursts
+	// ended by yielding or blocking (in ns)
+	unsigned int adaptQuantum;
+	bool interactive;
+	uint64_t burstStart;
+	uint64_t avgBurst;
+
+	// Times switched out, and how many of those were preemptions
+	unsigned long switches;
+	unsigned long preemptions;
+
+	// Priority and absolute deadline (0 if none) set by the user
+	int basePrio;
+	uint64_t deadline;
+
+	// Thread group (NULL for the default group)
+	struct uthread_group* group;
+
+	// Scheduling state private to the policies
+	unsigned int boostEpoch;
+	uint64_t vruntime;
+	uint64_t charged;
+	void* policyData;
+
+	// Saved registers
+	_Alignas(UTHREAD_CACHE_LINE) uthread_ctx_t context;
+
+	// Cold: bottom of the stack, which the TCB sits right above
+	void* stack;
+
+	// Allocation shared with the threads created in the same batch, which
+	// owns the TCB and stack (NULL if allocated separately), and entry point
+	// until the context is initialized on first run
+	struct uthread_batch* batch;
+	uthread_func_t func;
+	void* arg;
+
+	// Function the thread was created with
+	uthread_func_t entry;
+
+	// Pool worker running a job (NULL otherwise), see pool_worker_block()
+	struct pool_worker* poolWorker;
+
+	// Generator the thread runs (NULL otherwise), see uthread_gen_yield()
+	struct generator* generator;
+
+	// Memory from uthread_alloc(), released when the thread exits
+	struct arena arena;
+
+	// Wake-ups from outside the scheduler: scheduler the thread belongs to,
+	// link in its inbox, and whether the thread is parked or has a wake-up
+	// pending, see uthread_park()
+	struct uthread_sched* sched;
+	struct inbox_node inboxNode;
+	atomic_int parkState;
+
+	// Threads on the shared stack (NULL stack): copy of the part of the
+	// stack in use while switched out, and size of the buffer holding it
+	void* savedStack;
+	size_t savedSize;
+	size_t savedCapacity;
+
+	struct uthread_deadline_stats deadlineStats;
+
+	// Thread-local storage, indexed directly by key, each value along with
+	// the generation of the key it was set for
+	struct uthread_tls_slot tls[UTHREAD_KEYS_MAX];
+	void* userdata;
+};
+typedef struct uthread_tcb uthread_tcb;
+
+/*
+ * thread_queue - Queue of threads, linked through their TCBs
+ */
+QUEUE_DEFINE(thread_queue, struct uthread_tcb, queueLink)
+
+/*
+ * uthread_sched - Scheduler, run by a single kernel thread
+ *
+ * The first part is only used by the scheduler's own kernel thread, which
+ * finds it through a thread-local pointer, so that schedulers of different
+ * kernel threads share nothing. The second part, starting on a cache line of
+ * its own, is reachable from other kernel threads.
+ */
+struct uthread_sched {
+	// Scheduling policy, its run queue, number of ready threads, and number
+	// of threads the policy made room for, see uthread_admit()
+	const struct uthread_policy* policy;
+	void* runQueue;
+	int readyCount;
+	unsigned int threadCount;
+
+	// Time slices: length given to threads that don't have their own (in
+	// microseconds), whether the timer is stopped while a single thread
+	// can run, whether slices are tuned to each thread's behavior, and
+	// number of ready threads whose slices got shorter than the default
+	unsigned int quantum;
+	bool tickless;
+	bool adaptive;
+	int interactiveCount;
+
+	// Running thread, thread switched out last, idle thread, and threads
+	// exited but not collected yet
+	struct uthread_tcb* runningThread;
+	struct uthread_tcb* previousThread;
+	struct uthread_tcb* idleThread;
+	struct thread_queue exitedQueue;
+
+	// Parked threads, which only the inbox can wake up, threads waiting for
+	// a file descriptor, and switches since it was last checked
+	int parkedCount;
+	int ioWaiting;
+	unsigned int ioSwitches;
+
+	// Arena chunks released by exited threads
+	struct arena_cache arenaCache;
+
+	struct preempt_timer timer;
+
+	// Deadlines met and missed, and scheduling statistics, of all threads
+	struct uthread_deadline_stats deadlineStats;
+	struct uthread_stats stats;
+
+	// Reachable from other kernel threads: threads woken up by
+	// uthread_unpark(), threads requested by uthread_spawn_remote() and
+	// requests still being made, event counter that wakes the scheduler up,
+	// epoll instance it sleeps on while idle, and whether it is sleeping (or
+	// about to), stopped by uthread_sched_stop(), and running
+	_Alignas(UTHREAD_CACHE_LINE) struct inbox wakeups;
+	struct inbox spawns;
+	atomic_int spawning;
+	int eventFd;
+	int epollFd;
+	atomic_bool sleeping;
+	atomic_bool stopped;
+	atomic_bool running;
+
+	// Whether the scheduler keeps running once it has no thread left, until
+	// stopped
+	bool keepalive;
+};
 
 /*
  * uthread_current - Get currently running thread
@@ -114,6 +691,14 @@ struct uthread_tcb;
  */
 struct uthread_tcb *uthread_current(void);
 
+/*
+ * uthread_arena_release - Release memory allocated by the running thread
+ *
+ * For threads that start over without exiting, like pool workers between
+ * jobs. Must be called with preemption disabled.
+ */
+void uthread_arena_release(void);
+
 /*
  * uthread_block - Block currently running thread
  */
@@ -125,4 +710,52 @@ void uthread_block(void);
  */
 void uthread_unblock(struct uthread_tcb *uthread);
 
+/*
+ * uthread_tick - Handle end of time slice of currently running thread
+ *
+ * Called by the timer interrupt handler. Let the scheduling policy decide
+ * whether the running thread is preempted.
+ */
+void uthread_tick(void);
+
+/*
+ * uthread_new - Allocate a thread without scheduling it
+ * @func: Function to be executed by the thread
+ * @arg: Argument to be passed to the thread
+ *
+ * The new thread is left blocked: it only runs once it is unblocked or
+ * switched to directly.
+ *
+ * Return: Pointer to new thread's TCB, or NULL in case of failure
+ */
+struct uthread_tcb *uthread_new(uthread_func_t func, void *arg);
+
+/*
+ * uthread_block_to - Block currently running thread and resume another one
+ * @target: TCB of thread to resume, which can be blocked or ready
+ *
+ * Unlike uthread_block(), the next thread to run is not taken from the ready
+ * queue.
+ */
+void uthread_block_to(struct uthread_tcb *target);
+
+/*
+ * uthread_update - Change scheduling parameters of a thread
+ * @thread: TCB of thread to modify
+ * @update: Function modifying @thread
+ * @arg: Argument to be passed to @update
+ *
+ * If @thread is ready, it is taken out of the run queue while @update runs and
+ * put back in afterwards, so that the scheduling policy sees the change.
+ */
+void uthread_update(struct uthread_tcb *thread,
+		    void (*update)(struct uthread_tcb *thread, void *arg), void *arg);
+
+/*
+ * uthread_clock - Read the scheduler's clock
+ *
+ * Return: Monotonic time in nanoseconds
+ */
+uint64_t uthread_clock(void);
+
 #endif /* _UTHREAD_PRIVATE_H */
@@ -13,11 +13,13 @@ typedef struct node* node_t;
 /*
  * node_t - Node type
  *
- * A node is a data structure holding one data value and a link to another node.
+ * A node is a data structure holding one data value and links to the nodes
+ * before and after it, so that it can be unlinked without searching for it.
  */
 struct node {
     void* data;
 	node_t next;
+	node_t prev;
 };
 
 /**
@@ -36,7 +38,7 @@ node_t node_create(void* data) {
 	}
 
 	node->data = data;
-	node->next = NULL;
+	node->next = node->prev = NULL;
 	return node;
 }
 
@@ -96,9 +98,16 @@ int queue_destroy(queue_t queue)
 }
 
 int queue_enqueue(queue_t queue, void *data)
+{
+	queue_handle_t handle;
+
+	return queue_enqueue_handle(queue, data, &handle);
+}
+
+int queue_enqueue_handle(queue_t queue, void *data, queue_handle_t *handle)
 {
 	// Check for memory allocation error
-	if (queue == NULL || data == NULL) {
+	if (queue == NULL || data == NULL || handle == NULL) {
 		return -1;
 	}
 
@@ -115,14 +124,16 @@ int queue_enqueue(queue_t queue, void *data)
 	} else {
 		// Non-empty queue
 		queue->back->next = newNode;
+		newNode->prev = queue->back;
 	}
 	// Set back of queue to new node
 	queue->back = newNode;
 
 	// Update queue size
 	queue->size++;
-	
+
 	// Successfully enqueued in queue
+	*handle = newNode;
 	return 0;
 }
 
@@ -146,6 +157,8 @@ int queue_dequeue(queue_t queue, void **data)
 	if (queue->front == NULL) {
 		// Empty queue, back just removed
 		queue->back = NULL;
+	} else {
+		queue->front->prev = NULL;
 	}
 
 	// Update queue size
@@ -154,44 +167,150 @@ int queue_dequeue(queue_t queue, void **data)
 	return 0;
 }
 
-int queue_delete(queue_t queue, void *data)
+int queue_enqueue_bulk(queue_t queue, void *data[], int n)
 {
-	if (queue == NULL || data == NULL) {
+	if (queue == NULL || data == NULL || n < 0) {
 		return -1;
 	}
-	
-	// Special case if first node (no previous node)
-	if (queue->front->data == data) {
-		// Deleting first node is equivalent of dequeuing (data not used)
-		queue_dequeue(queue, &data); 
+
+	// Items are chained on their own first, so that nothing is enqueued if
+	// one of them can't be
+	node_t front = NULL;
+	node_t back = NULL;
+
+	for (int i = 0; i < n; i++) {
+		node_t newNode = data[i] != NULL ? node_create(data[i]) : NULL;
+		if (newNode == NULL) {
+			// Memory allocation error, or NULL item
+			while (front != NULL) {
+				node_t nextNode = front->next;
+				node_destroy(front);
+				front = nextNode;
+			}
+			return -1;
+		}
+
+		if (back == NULL) {
+			front = newNode;
+		} else {
+			back->next = newNode;
+			newNode->prev = back;
+		}
+		back = newNode;
+	}
+
+	if (front == NULL) {
 		return 0;
 	}
 
-	node_t node = queue->front;
-	node_t back = queue->back;
+	// Chain joins the back of queue at once
+	if (queue->back == NULL) {
+		queue->front = front;
+	} else {
+		queue->back->next = front;
+		front->prev = queue->back;
+	}
+	queue->back = back;
+	queue->size += n;
 
-	// In linked list, node must be deleted using the preceding node
+	return 0;
+}
 
-	while (node != back) {
-		// Get next node in queue
-		node_t nextNode = node->next;
+int queue_dequeue_bulk(queue_t queue, void *data[], int max)
+{
+	if (queue == NULL || data == NULL || max < 0) {
+		return -1;
+	}
+
+	int count = 0;
 
-		// Find right node to delete
-		if (nextNode->data == data) {
-			// Mode to delete, set node before to skip and point to node after
-			node->next = nextNode->next;
-			// Deallocate node
-			node_destroy(nextNode);
-			// Decrement queue size
-			queue->size--;
-			return 0;
+	while (count < max && queue->front != NULL) {
+		node_t frontNode = queue->front;
+
+		data[count++] = frontNode->data;
+		queue->front = frontNode->next;
+		node_destroy(frontNode);
+	}
+
+	// Queue is only linked again once, at its new front
+	if (queue->front == NULL) {
+		queue->back = NULL;
+	} else {
+		queue->front->prev = NULL;
+	}
+	queue->size -= count;
+
+	return count;
+}
+
+int queue_splice(queue_t dst, queue_t src)
+{
+	if (dst == NULL || src == NULL || dst == src) {
+		return -1;
+	}
+
+	if (src->front == NULL) {
+		return 0;
+	}
+
+	// Whole source chain joins the back of destination, nodes are kept
+	if (dst->back == NULL) {
+		dst->front = src->front;
+	} else {
+		dst->back->next = src->front;
+		src->front->prev = dst->back;
+	}
+	dst->back = src->back;
+	dst->size += src->size;
+
+	src->front = src->back = NULL;
+	src->size = 0;
+
+	return 0;
+}
+
+int queue_delete(queue_t queue, void *data)
+{
+	if (queue == NULL || data == NULL) {
+		return -1;
+	}
+
+	// Find oldest node holding data, if any (none in an empty queue)
+	for (node_t node = queue->front; node != NULL; node = node->next) {
+		if (node->data == data) {
+			return queue_remove_handle(queue, node);
 		}
-		node = nextNode;
 	}
 
 	return -1; // data not found
 }
 
+int queue_remove_handle(queue_t queue, queue_handle_t handle)
+{
+	if (queue == NULL || handle == NULL) {
+		return -1;
+	}
+
+	// Nodes around it skip it, front and back move if it was either
+	if (handle->prev == NULL) {
+		queue->front = handle->next;
+	} else {
+		handle->prev->next = handle->next;
+	}
+	if (handle->next == NULL) {
+		queue->back = handle->prev;
+	} else {
+		handle->next->prev = handle->prev;
+	}
+
+	// Deallocate node
+	node_destroy(handle);
+	// Decrement queue size
+	queue->size--;
+
+	return 0;
+}
+
 int queue_iterate(queue_t queue, queue_func_t func)
 {	 
 	if (queue == NULL || func == NULL) {
@@ -12,6 +12,15 @@
  */
 typedef struct queue* queue_t;
 
+/*
+ * queue_handle_t - Queue item handle
+ *
+ * Position of an item in a queue, given when enqueueing it, through which the
+ * item can be removed in O(1) wherever it is in the queue. A handle is only
+ * valid until its item leaves the queue, by whichever operation.
+ */
+typedef struct node* queue_handle_t;
+
 /*
  * queue_create - Allocate an empty queue
  *
@@ -45,6 +54,21 @@ int queue_destroy(queue_t queue);
  */
 int queue_enqueue(queue_t queue, void *data);
 
+/*
+ * queue_enqueue_handle - Enqueue data item and get its handle
+ * @queue: Queue in which to enqueue item
+ * @data: Address of data item to enqueue
+ * @handle: Address of handle where the item's position is received
+ *
+ * Same as queue_enqueue(), and set @handle so that the item can later be
+ * removed with queue_remove_handle().
+ *
+ * Return: -1 if @queue, @data or @handle are NULL, or in case of memory
+ * allocation error when enqueing. 0 if @data was successfully enqueued in
+ * @queue.
+ */
+int queue_enqueue_handle(queue_t queue, void *data, queue_handle_t *handle);
+
 /*
  * queue_dequeue - Dequeue data item
  * @queue: Queue in which to dequeue item
@@ -58,6 +82,49 @@ int queue_enqueue(queue_t queue, void *data);
  */
 int queue_dequeue(queue_t queue, void **data);
 
+/*
+ * queue_enqueue_bulk - Enqueue several data items
+ * @queue: Queue in which to enqueue items
+ * @data: Array of addresses of data items to enqueue
+ * @n: Number of items in @data
+ *
+ * Enqueue the @n addresses contained in @data in the queue @queue, in the order
+ * of the array. Either all items are enqueued, or none.
+ *
+ * Return: -1 if @queue or @data are NULL, if @n is negative, if one of the
+ * items is NULL, or in case of memory allocation error when enqueing. 0 if all
+ * items were successfully enqueued in @queue.
+ */
+int queue_enqueue_bulk(queue_t queue, void *data[], int n);
+
+/*
+ * queue_dequeue_bulk - Dequeue several data items
+ * @queue: Queue in which to dequeue items
+ * @data: Array where items are received
+ * @max: Maximum number of items to dequeue, size of @data
+ *
+ * Remove the oldest items of queue @queue, up to @max of them, and assign them
+ * to the first entries of @data, oldest first.
+ *
+ * Return: -1 if @queue or @data are NULL, or if @max is negative. Number of
+ * items dequeued otherwise, 0 if the queue is empty.
+ */
+int queue_dequeue_bulk(queue_t queue, void *data[], int max);
+
+/*
+ * queue_splice - Move all items of a queue to another one
+ * @dst: Queue in which to enqueue items
+ * @src: Queue from which to take items
+ *
+ * Move all the items of queue @src, in their order, to the back of queue @dst
+ * in O(1). @src is left empty, and the handles of the items moved are still
+ * valid, now for @dst.
+ *
+ * Return: -1 if @dst or @src are NULL, or if they are the same queue. 0 if the
+ * items were moved.
+ */
+int queue_splice(queue_t dst, queue_t src);
+
 /*
  * queue_delete - Delete data item
  * @queue: Queue in which to delete item
@@ -71,6 +138,20 @@ int queue_dequeue(queue_t queue, void **data);
  */
 int queue_delete(queue_t queue, void *data);
 
+/*
+ * queue_remove_handle - Remove data item by its handle
+ * @queue: Queue in which to remove item
+ * @handle: Handle of the item, as given by queue_enqueue_handle()
+ *
+ * Remove the item at @handle from queue @queue in O(1), wherever it is in the
+ * queue. @handle must be the handle of an item still in @queue, and is no
+ * longer valid afterwards.
+ *
+ * Return: -1 if @queue or @handle are NULL. 0 if the item was removed from
+ * @queue.
+ */
+int queue_remove_handle(queue_t queue, queue_handle_t handle);
+
 /*
  * queue_func_t - Queue callback function type
  * @queue: Queue to which item belongs
@@ -0,0 +1,255 @@
+#include <errno.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "private.h"
+#include "uthread.h"
+
+/* Thread creation requested from outside the scheduler */
+struct sched_spawn {
+	struct inbox_node node;
+	uthread_func_t func;
+	void *arg;
+};
+
+/*
+ * sched_init - Initialize a scheduler
+ *
+ * Return: 0 in case of success, -1 in case of failure when creating the event
+ * counter or the epoll instance
+ */
+static int sched_init(struct uthread_sched *sched, bool keepalive)
+{
+	memset(sched, 0, sizeof(*sched));
+	inbox_init(&sched->wakeups);
+	inbox_init(&sched->spawns);
+	atomic_store(&sched->spawning, 0);
+	atomic_store(&sched->sleeping, false);
+	atomic_store(&sched->stopped, false);
+	atomic_store(&sched->running, false);
+	sched->keepalive = keepalive;
+
+	sched->eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (sched->eventFd < 0) {
+		return -1;
+	}
+
+	// Kicks come in as events without a thread
+	struct epoll_event event;
+
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+
+	sched->epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (sched->epollFd < 0 ||
+	    epoll_ctl(sched->epollFd, EPOLL_CTL_ADD, sched->eventFd, &event)) {
+		if (sched->epollFd >= 0) {
+			close(sched->epollFd);
+		}
+		close(sched->eventFd);
+		return -1;
+	}
+
+	return 0;
+}
+
+struct uthread_sched *sched_create(bool keepalive)
+{
+	// Allocated from a kernel thread that isn't running a scheduler yet, so
+	// with no tick to fear
+	struct uthread_sched *sched = aligned_alloc(UTHREAD_CACHE_LINE,
+						    sizeof(struct uthread_sched));
+	if (sched == NULL) {
+		return NULL;
+	}
+
+	if (sched_init(sched, keepalive)) {
+		free(sched);
+		return NULL;
+	}
+
+	return sched;
+}
+
+void sched_destroy(struct uthread_sched *sched)
+{
+	uthread_func_t func;
+	void *arg;
+
+	// Requests rejected after the stop may still be looking at the scheduler
+	while (atomic_load(&sched->spawning) > 0) {
+		sched_yield();
+	}
+
+	// Threads requested too late to be created
+	while (sched_spawn_pop(sched, &func, &arg)) {
+	}
+
+	close(sched->epollFd);
+	close(sched->eventFd);
+	free(sched);
+}
+
+void sched_kick(struct uthread_sched *sched)
+{
+	// Only worth a system call if the scheduler is sleeping, or about to
+	if (!atomic_load(&sched->sleeping)) {
+		return;
+	}
+
+	uint64_t one = 1;
+	ssize_t ret;
+
+	do {
+		ret = write(sched->eventFd, &one, sizeof(one));
+	} while (ret < 0 && errno == EINTR);
+}
+
+int sched_poll(struct uthread_sched *sched, bool block,
+	       struct uthread_tcb **threads, int max)
+{
+	struct epoll_event events[max];
+	int timeout = 0;
+
+	// Producers check the flag after pushing, and the inboxes are checked
+	// after setting it, so that one side at least sees the other
+	if (block) {
+		atomic_store(&sched->sleeping, true);
+		if (inbox_empty(&sched->wakeups) && inbox_empty(&sched->spawns) &&
+		    !atomic_load(&sched->stopped)) {
+			timeout = -1;
+		}
+	}
+
+	// Interrupted by a signal, the caller comes back if needed
+	int ready = epoll_wait(sched->epollFd, events, max, timeout);
+	int count = 0;
+
+	for (int i = 0; i < ready; i++) {
+		if (events[i].data.ptr != NULL) {
+			threads[count++] = events[i].data.ptr;
+			continue;
+		}
+
+		// Kicked, the event counter is reset for the next time
+		uint64_t kicks;
+		ssize_t ret;
+
+		do {
+			ret = read(sched->eventFd, &kicks, sizeof(kicks));
+		} while (ret < 0 && errno == EINTR);
+	}
+
+	if (block) {
+		atomic_store(&sched->sleeping, false);
+	}
+
+	return count;
+}
+
+bool sched_spawn_pop(struct uthread_sched *sched, uthread_func_t *func, void **arg)
+{
+	struct inbox_node *node = inbox_pop(&sched->spawns);
+	if (node == NULL) {
+		return false;
+	}
+
+	struct sched_spawn *spawn = container_of(node, struct sched_spawn, node);
+
+	*func = spawn->func;
+	*arg = spawn->arg;
+	free(spawn);
+
+	return true;
+}
+
+uthread_sched_t uthread_sched_create(void)
+{
+	if (uthread_sched_self() != NULL) {
+		return NULL;
+	}
+
+	return sched_create(true);
+}
+
+int uthread_sched_destroy(uthread_sched_t sched)
+{
+	if (sched == NULL || atomic_load(&sched->running)) {
+		return -1;
+	}
+
+	sched_destroy(sched);
+
+	return 0;
+}
+
+int uthread_sched_stop(uthread_sched_t sched)
+{
+	if (sched == NULL) {
+		return -1;
+	}
+
+	atomic_store(&sched->stopped, true);
+	sched_kick(sched);
+
+	return 0;
+}
+
+/*
+ * spawn_remote - Queue a thread request, see uthread_spawn_remote()
+ *
+ * Called while counted in @sched->spawning.
+ */
+static int spawn_remote(uthread_sched_t sched, uthread_func_t func, void *arg)
+{
+	if (atomic_load(&sched->stopped)) {
+		return -1;
+	}
+
+	// From a thread of any scheduler, the allocator must not be interrupted
+	// by a tick
+	bool local = uthread_sched_self() != NULL;
+
+	if (local) {
+		preempt_disable();
+	}
+	struct sched_spawn *spawn = malloc(sizeof(struct sched_spawn));
+	if (local) {
+		preempt_enable();
+	}
+	if (spawn == NULL) {
+		return -1;
+	}
+
+	spawn->func = func;
+	spawn->arg = arg;
+
+	// Threads are created in batches by the scheduler, at its next switch
+	inbox_push(&sched->spawns, &spawn->node);
+	sched_kick(sched);
+
+	return 0;
+}
+
+int uthread_spawn_remote(uthread_sched_t sched, uthread_func_t func, void *arg)
+{
+	if (sched == NULL || func == NULL) {
+		return -1;
+	}
+
+	// Scheduler doesn't return while a request that got past the stop check
+	// isn't queued, nor is it destroyed while a request looks at it
+	atomic_fetch_add(&sched->spawning, 1);
+	int ret = spawn_remote(sched, func, arg);
+	atomic_fetch_sub(&sched->spawning, 1);
+
+	return ret;
+}
@@ -1,28 +1,31 @@
 #include <stddef.h>
 #include <stdlib.h>
 
-#include "queue.h"
 #include "sem.h"
 #include "private.h"
 
 struct semaphore {
 	int count;
-	queue_t blockedQueue;
+	struct thread_queue blockedQueue;
 };
 
 sem_t sem_create(size_t count)
 {
+	// Dealing with the allocator, which can't be reentered, so disable preempt
+	preempt_disable();
+
 	// Allocate space for semaphore
 	sem_t semaphore = (sem_t) malloc(sizeof(struct semaphore));
 
-	// Dealing with shared data structure, so disable preempt
-	preempt_disable();
+	// Enable preemp after done with allocator
+	preempt_enable();
 
-	// Create blocked queue for threads (waitlist)
-	semaphore->blockedQueue = queue_create();
+	if (semaphore == NULL) {
+		return NULL;
+	}
 
-	// Enable preemp after done with queue
-	preempt_enable();
+	// Blocked queue for threads (waitlist), linked through their TCBs
+	thread_queue_init(&semaphore->blockedQueue);
 
 	// Initialize count
 	semaphore->count = count;
@@ -32,12 +35,13 @@ sem_t sem_create(size_t count)
 
 int sem_destroy(sem_t sem)
 {
-	if (sem == NULL || queue_length(sem->blockedQueue) != 0) {
+	if (sem == NULL || thread_queue_length(&sem->blockedQueue) != 0) {
 		return -1;
 	}
 
-	queue_destroy(sem->blockedQueue);
+	preempt_disable();
 	free(sem);	// Deallocate memory
+	preempt_enable();
 
 	return 0;
 }
@@ -59,11 +63,10 @@ int sem_down(sem_t sem)
 		preempt_disable();
 
 		// Add thread to waiting queue
-		queue_enqueue(sem->blockedQueue, thread);
-
-		preempt_enable();
+		thread_queue_enqueue(&sem->blockedQueue, thread);
 
-		// Block thread
+		// Block thread (preemption stays disabled until it is switched out,
+		// and is enabled again when it resumes)
 		uthread_block();
 	}
 
@@ -79,17 +82,15 @@ int sem_up(sem_t sem)
 	sem->count++;
 
 	// Check if threads are waiting for resource
-	if (queue_length(sem->blockedQueue) > 0) {
+	if (thread_queue_length(&sem->blockedQueue) > 0) {
 
 		// Acquire resource for next waiting thread
 		sem_down(sem);
 
 		// Unblock thread and remove from waiting queue
-		struct uthread_tcb* thread;
-
 		preempt_disable();
 
-		queue_dequeue(sem->blockedQueue, (void**) &thread);
+		struct uthread_tcb* thread = thread_queue_dequeue(&sem->blockedQueue);
 
 		preempt_enable();
 
@@ -97,4 +98,28 @@ int sem_up(sem_t sem)
 	}
 
 	return 0;
-}
\ No newline at end of file
+}
+
+int sem_broadcast(sem_t sem)
+{
+	if (sem == NULL) {
+		return -1;
+	}
+
+	// Only threads waiting now: woken threads may run right away, and block
+	// again on the semaphore's list rather than this one
+	struct thread_queue waiting;
+	struct uthread_tcb* thread;
+
+	thread_queue_init(&waiting);
+
+	preempt_disable();
+	thread_queue_splice(&waiting, &sem->blockedQueue);
+	preempt_enable();
+
+	while ((thread = thread_queue_dequeue(&waiting)) != NULL) {
+		uthread_unblock(thread);
+	}
+
+	return 0;
+}
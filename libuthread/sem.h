@@ -64,4 +64,17 @@ int sem_down(sem_t sem);
  */
 int sem_up(sem_t sem);
 
+/*
+ * sem_broadcast - Wake up all waiting threads
+ * @sem: Semaphore to broadcast on
+ *
+ * Unblock every thread currently in the waiting list associated to @sem, oldest
+ * first, as if each one was given a resource of its own. The internal count of
+ * @sem is left unchanged, and threads that block on @sem while the others
+ * are being woken up keep waiting.
+ *
+ * Return: -1 if @sem is NULL. 0 if the waiting threads were unblocked.
+ */
+int sem_broadcast(sem_t sem);
+
 #endif /* _SEMAPHORE_H */
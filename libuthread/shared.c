@@ -0,0 +1,162 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "private.h"
+#include "uthread.h"
+
+/*
+ * Shared stack
+ *
+ * Threads created with uthread_create_shared() all run on the same stack. The
+ * stack of the thread that last ran there, called its owner, is left in place
+ * when it is switched out, so that nothing is copied if it is the next thread
+ * on the shared stack to run. Otherwise, the part of the owner's stack in use
+ * is copied out to a buffer of its own, and the one of the next thread copied
+ * back in.
+ *
+ * This can't be done while running on the shared stack, so the switch goes
+ * through a trampoline context with a stack of its own.
+ */
+
+/*
+ * Bytes below the saved stack pointer that may still be in use (red zone of
+ * the x86-64 ABI)
+ */
+#define SHARED_RED_ZONE 128
+
+/* Shared stack of the calling kernel thread's scheduler, and its trampoline */
+static _Thread_local char *sharedStack;
+static _Thread_local struct uthread_tcb *owner;
+
+static _Thread_local char *trampolineStack;
+static _Thread_local uthread_ctx_t trampolineContext;
+static _Thread_local struct uthread_tcb *trampolineNext;
+
+/*
+ * shared_stack_save - Copy owner's stack out of the shared stack
+ */
+static void shared_stack_save(struct uthread_tcb *thread)
+{
+	char *top = sharedStack + UTHREAD_SHARED_STACK_SIZE;
+	char *sp = (char *) uthread_ctx_stack_pointer(&thread->context) - SHARED_RED_ZONE;
+
+	if (sp < sharedStack) {
+		sp = sharedStack;
+	}
+	size_t size = top - sp;
+
+	// Buffer fits what is in use, and is shrunk if it got far too big
+	if (size > thread->savedCapacity || size < thread->savedCapacity / 4) {
+		void *buffer = realloc(thread->savedStack, size);
+		if (buffer == NULL) {
+			// Nowhere to move the stack to, memory allocation error
+			abort();
+		}
+		thread->savedStack = buffer;
+		thread->savedCapacity = size;
+	}
+
+	memcpy(thread->savedStack, sp, size);
+	thread->savedSize = size;
+}
+
+/*
+ * shared_stack_restore - Prepare thread to run on the shared stack
+ */
+static void shared_stack_restore(struct uthread_tcb *thread)
+{
+	// First run, the stack is empty
+	if (thread->func != NULL) {
+		uthread_ctx_init(&thread->context, sharedStack, thread->func, thread->arg);
+		thread->func = NULL;
+		return;
+	}
+
+	memcpy(sharedStack + UTHREAD_SHARED_STACK_SIZE - thread->savedSize,
+	       thread->savedStack, thread->savedSize);
+}
+
+/*
+ * shared_stack_trampoline - Swap stacks and resume next thread, forever
+ */
+static void shared_stack_trampoline(void *arg)
+{
+	uthread_ctx_t *caller = arg;
+
+	// Started once by shared_stack_init(), and only ever switched to with
+	// preemption disabled afterwards
+	preempt_disable();
+	uthread_ctx_switch(&trampolineContext, caller);
+
+	for (;;) {
+		// Stack of an exited thread can be overwritten
+		if (owner != NULL && owner->state != EXITED) {
+			shared_stack_save(owner);
+		}
+
+		owner = trampolineNext;
+		shared_stack_restore(owner);
+
+		uthread_ctx_switch(&trampolineContext, &owner->context);
+	}
+}
+
+int shared_stack_init(void)
+{
+	if (sharedStack != NULL) {
+		return 0;
+	}
+
+	uthread_ctx_t caller;
+
+	sharedStack = malloc(UTHREAD_SHARED_STACK_SIZE);
+	trampolineStack = malloc(UTHREAD_STACK_SIZE);
+	if (sharedStack == NULL || trampolineStack == NULL ||
+	    uthread_ctx_init(&trampolineContext, trampolineStack,
+			     shared_stack_trampoline, &caller) == -1) {
+		shared_stack_fini();
+		return -1;
+	}
+
+	// Stack pointer of switched out threads needs to be known
+	if (uthread_ctx_stack_pointer(&trampolineContext) == NULL) {
+		shared_stack_fini();
+		return -1;
+	}
+
+	// Get trampoline past its startup, so that it is ready for switches
+	uthread_ctx_switch(&caller, &trampolineContext);
+
+	return 0;
+}
+
+void shared_stack_fini(void)
+{
+	free(sharedStack);
+	free(trampolineStack);
+	sharedStack = trampolineStack = NULL;
+	owner = NULL;
+}
+
+void shared_stack_switch(uthread_ctx_t *prev, struct uthread_tcb *next)
+{
+	// Stack is already in place
+	if (next == owner) {
+		uthread_ctx_switch(prev, &next->context);
+		return;
+	}
+
+	trampolineNext = next;
+	uthread_ctx_switch(prev, &trampolineContext);
+}
+
+void shared_stack_release(struct uthread_tcb *thread)
+{
+	if (thread == owner) {
+		owner = NULL;
+	}
+
+	free(thread->savedStack);
+}
@@ -0,0 +1,144 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "private.h"
+#include "uthread.h"
+
+/*
+ * Stack usage
+ *
+ * New stacks are filled with a known pattern. When a thread exits, the part of
+ * its stack that still holds the pattern, from the bottom up, was never used,
+ * and the rest gives the deepest its stack ever got. Results are gathered per
+ * entry function, as threads started by the same function usually need the
+ * same amount of stack.
+ */
+#define STACK_CANARY 0x5354414b43414e59ULL	/* "STAKCANY" */
+
+/* Measures of the calling kernel thread's scheduler */
+static _Thread_local bool enabled;
+static _Thread_local struct uthread_stack_usage *usage;
+static _Thread_local size_t count;
+static _Thread_local size_t capacity;
+
+void stack_usage_start(bool enable)
+{
+	enabled = enable;
+	count = 0;
+}
+
+bool stack_usage_enabled(void)
+{
+	return enabled;
+}
+
+void stack_usage_fill(void *stack)
+{
+	uint64_t *word = stack;
+
+	for (size_t i = 0; i < UTHREAD_STACK_SIZE / sizeof(uint64_t); i++) {
+		word[i] = STACK_CANARY;
+	}
+}
+
+/*
+ * stack_usage_find - Get usage entry of an entry function, adding it if needed
+ *
+ * Return: Pointer to entry, or NULL in case of failure when allocating it
+ */
+static struct uthread_stack_usage *stack_usage_find(uthread_func_t func)
+{
+	for (size_t i = 0; i < count; i++) {
+		if (usage[i].func == func) {
+			return &usage[i];
+		}
+	}
+
+	if (count == capacity) {
+		size_t newCapacity = capacity != 0 ? capacity * 2 : 16;
+		struct uthread_stack_usage *newUsage =
+			realloc(usage, newCapacity * sizeof(*newUsage));
+		if (newUsage == NULL) {
+			return NULL;
+		}
+		usage = newUsage;
+		capacity = newCapacity;
+	}
+
+	memset(&usage[count], 0, sizeof(usage[count]));
+	usage[count].func = func;
+
+	return &usage[count++];
+}
+
+void stack_usage_record(uthread_func_t func, const void *stack)
+{
+	const uint64_t *word = stack;
+	size_t unused = 0;
+
+	// Stack grows down, towards its bottom
+	while (unused < UTHREAD_STACK_SIZE / sizeof(uint64_t) &&
+	       word[unused] == STACK_CANARY) {
+		unused++;
+	}
+	size_t used = UTHREAD_STACK_SIZE - unused * sizeof(uint64_t);
+
+	struct uthread_stack_usage *entry = stack_usage_find(func);
+	if (entry == NULL) {
+		// Memory allocation error, measure is lost
+		return;
+	}
+
+	size_t bucket = used * UTHREAD_STACK_BUCKETS / UTHREAD_STACK_SIZE;
+	if (bucket == UTHREAD_STACK_BUCKETS) {
+		bucket--;
+	}
+
+	entry->threads++;
+	entry->total += used;
+	entry->histogram[bucket]++;
+	if (used > entry->max) {
+		entry->max = used;
+	}
+}
+
+size_t uthread_stack_usage(struct uthread_stack_usage *entries, size_t n)
+{
+	preempt_disable();
+
+	if (entries != NULL) {
+		memcpy(entries, usage, (n < count ? n : count) * sizeof(*entries));
+	}
+	size_t total = count;
+
+	preempt_enable();
+
+	return total;
+}
+
+void uthread_stack_report(void)
+{
+	preempt_disable();
+
+	fprintf(stderr, "uthread stack usage (%d bytes per stack, %d bytes per "
+		"histogram bucket):\n", UTHREAD_STACK_SIZE,
+		UTHREAD_STACK_SIZE / UTHREAD_STACK_BUCKETS);
+
+	for (size_t i = 0; i < count; i++) {
+		struct uthread_stack_usage *entry = &usage[i];
+
+		fprintf(stderr, "  %p: %lu threads, max %zu, avg %zu, histogram",
+			(void *) (uintptr_t) entry->func, entry->threads, entry->max,
+			entry->total / entry->threads);
+		for (int bucket = 0; bucket < UTHREAD_STACK_BUCKETS; bucket++) {
+			fprintf(stderr, " %lu", entry->histogram[bucket]);
+		}
+		fprintf(stderr, "\n");
+	}
+
+	preempt_enable();
+}
@@ -0,0 +1,134 @@
+#ifndef _TQUEUE_H
+#define _TQUEUE_H
+
+/*
+ * This header is only meant to be included by files from the libuthread.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Typed queues
+ *
+ * FIFO queues of structures that embed their own link, so that no operation
+ * allocates, and an item can be removed from wherever it is in O(1). Unlike
+ * queue_t, operations are generated for each item type as static inline
+ * functions, which take and return that type and don't check their arguments.
+ * An item can only be in one queue at a time per link it embeds.
+ */
+
+/*
+ * QUEUE_LINK - Link embedded in items of type @type
+ */
+#define QUEUE_LINK(type) \
+	struct { \
+		type *next; \
+		type *prev; \
+	}
+
+/*
+ * QUEUE_DEFINE - Define a queue type and its operations
+ * @name: Name of the queue structure, and prefix of its operations
+ * @type: Type of the items
+ * @link: Name of the QUEUE_LINK() member of @type
+ *
+ * Define struct @name, and the following operations on it:
+ * - @name_init(queue): Initialize an empty queue
+ * - @name_length(queue): Number of items in queue
+ * - @name_enqueue(queue, item): Enqueue item at the back of queue
+ * - @name_push_front(queue, item): Enqueue item at the front of queue, so that
+ *   it is dequeued next
+ * - @name_dequeue(queue): Remove the oldest item and return it, or return NULL
+ *   if queue is empty
+ * - @name_remove(queue, item): Remove item, which must be in queue
+ * - @name_splice(dst, src): Move all items of src to the back of dst, leaving
+ *   src empty
+ */
+#define QUEUE_DEFINE(name, type, link) \
+struct name { \
+	type *front; \
+	type *back; \
+	int size; \
+}; \
+\
+static inline void name##_init(struct name *queue) \
+{ \
+	queue->front = queue->back = NULL; \
+	queue->size = 0; \
+} \
+\
+static inline int name##_length(const struct name *queue) \
+{ \
+	return queue->size; \
+} \
+\
+static inline void name##_enqueue(struct name *queue, type *item) \
+{ \
+	item->link.next = NULL; \
+	item->link.prev = queue->back; \
+	if (queue->back == NULL) { \
+		queue->front = item; \
+	} else { \
+		queue->back->link.next = item; \
+	} \
+	queue->back = item; \
+	queue->size++; \
+} \
+\
+static inline void name##_push_front(struct name *queue, type *item) \
+{ \
+	item->link.prev = NULL; \
+	item->link.next = queue->front; \
+	if (queue->front == NULL) { \
+		queue->back = item; \
+	} else { \
+		queue->front->link.prev = item; \
+	} \
+	queue->front = item; \
+	queue->size++; \
+} \
+\
+static inline void name##_remove(struct name *queue, type *item) \
+{ \
+	if (item->link.prev == NULL) { \
+		queue->front = item->link.next; \
+	} else { \
+		item->link.prev->link.next = item->link.next; \
+	} \
+	if (item->link.next == NULL) { \
+		queue->back = item->link.prev; \
+	} else { \
+		item->link.next->link.prev = item->link.prev; \
+	} \
+	item->link.next = item->link.prev = NULL; \
+	queue->size--; \
+} \
+\
+static inline type *name##_dequeue(struct name *queue) \
+{ \
+	type *item = queue->front; \
+\
+	if (item != NULL) { \
+		name##_remove(queue, item); \
+	} \
+	return item; \
+} \
+\
+static inline void name##_splice(struct name *dst, struct name *src) \
+{ \
+	if (src->front == NULL) { \
+		return; \
+	} \
+	src->front->link.prev = dst->back; \
+	if (dst->back == NULL) { \
+		dst->front = src->front; \
+	} else { \
+		dst->back->link.next = src->front; \
+	} \
+	dst->back = src->back; \
+	dst->size += src->size; \
+	name##_init(src); \
+}
+
+#endif /* _TQUEUE_H */
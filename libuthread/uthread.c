@@ -1,262 +1,1632 @@
+#define _GNU_SOURCE
 #include <assert.h>
 #include <signal.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
 
+#include "policy.h"
 #include "private.h"
 #include "uthread.h"
-#include "queue.h"
 
 
-enum State {RUNNING, READY, BLOCKED, EXITED};
-typedef enum State state_t;
+/*
+ * Number of passes over a thread's TLS slots when running destructors, in case
+ * destructors set new values
+ */
+#define UTHREAD_DESTRUCTOR_ITERATIONS 4
+
+/*
+ * Adaptive time slices: shortest and longest slices relative to the scheduler's
+ * quantum, and weight of the last burst in a thread's average burst length
+ * (1 / 2^UTHREAD_ADAPT_EWMA_SHIFT)
+ */
+#define UTHREAD_ADAPT_MIN_DIV 8
+#define UTHREAD_ADAPT_MAX_MULT 8
+#define UTHREAD_ADAPT_EWMA_SHIFT 2
+
+/*
+ * Park state of a thread: neither parked nor woken up, parked, or woken up by
+ * uthread_unpark() and not back from uthread_park() yet
+ */
+#define UTHREAD_PARK_NONE 0
+#define UTHREAD_PARK_PARKED 1
+#define UTHREAD_PARK_WOKEN 2
+
+/*
+ * Threads waiting for a file descriptor: switches between two checks while
+ * other threads are ready, and most threads made ready by a check
+ */
+#define UTHREAD_IO_POLL_INTERVAL 64
+#define UTHREAD_IO_EVENTS 64
+
+/*
+ * Thread-local storage keys, shared by all threads, including those of other
+ * kernel threads' schedulers. Generation changes each time a key is deleted,
+ * so that values set for it are not seen through the next key at its index
+ */
+struct uthread_key {
+	atomic_bool used;
+	atomic_uint generation;
+	void (*destructor)(void *value);
+};
+static struct uthread_key keys[UTHREAD_KEYS_MAX];
+
+/*
+ * Allocation holding the TCBs and stacks of threads created together by
+ * uthread_create_batch(), released once they have all been destroyed
+ */
+struct uthread_batch {
+	unsigned int live;
+	uthread_ctx_t model;
+};
+
+/*
+ * Hot fields of a TCB must share its first cache line, and a TCB allocated at
+ * the top of its stack must stay aligned
+ */
+_Static_assert(offsetof(uthread_tcb, runtime) + sizeof(uint64_t) <= UTHREAD_CACHE_LINE,
+	       "hot TCB fields don't fit in a cache line");
+_Static_assert(UTHREAD_STACK_SIZE % UTHREAD_CACHE_LINE == 0,
+	       "stack size is not a multiple of the cache line size");
+
+/*
+ * uthread_tcb_init - Initialize TCB with empty scheduling state and
+ * thread-local storage
+ * @thread: TCB to initialize
+ * @stack: Bottom of the thread's stack of UTHREAD_STACK_SIZE bytes
+ */
+static void uthread_tcb_init(uthread_tcb *thread, void *stack)
+{
+	// Context is left alone, it is entirely written when initialized
+	memset(thread, 0, offsetof(uthread_tcb, context));
+	memset(&thread->stack, 0, sizeof(uthread_tcb) - offsetof(uthread_tcb, stack));
+	thread->stack = stack;
+}
+
+/*
+ * Scheduler run by the calling kernel thread, or NULL outside of uthread_run().
+ * Each kernel thread can run a scheduler of its own, which shares nothing with
+ * the others
+ */
+static _Thread_local struct uthread_sched* sched;
+
+struct uthread_tcb *uthread_current(void)
+{
+	return sched != NULL ? sched->runningThread : NULL;
+}
+
+uthread_t uthread_self(void)
+{
+	return uthread_current();
+}
+
+uint64_t uthread_clock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * uthread_account - Charge time run so far to currently running thread
+ */
+static void uthread_account(void)
+{
+	uint64_t now = uthread_clock();
+
+	sched->runningThread->runtime += now - sched->runningThread->sliceStart;
+	if (sched->runningThread != sched->idleThread) {
+		sched->stats.runtime += now - sched->runningThread->sliceStart;
+	}
+	sched->runningThread->sliceStart = now;
+}
+
+/*
+ * uthread_quantum - Get length of a thread's time slices
+ *
+ * Slices lengthened by adaptive mode are only used while no thread with
+ * shortened slices is waiting, so that it doesn't wait any longer than it would
+ * otherwise.
+ *
+ * Return: Quantum set by the user for @thread, else quantum picked by adaptive
+ * mode, else the scheduler's default (in microseconds)
+ */
+static unsigned int uthread_quantum(uthread_tcb *thread)
+{
+	if (thread->quantum != 0) {
+		return thread->quantum;
+	}
+	if (sched->adaptive && thread->adaptQuantum != 0) {
+		if (thread->adaptQuantum > sched->quantum && sched->interactiveCount > 0) {
+			return sched->quantum;
+		}
+		return thread->adaptQuantum;
+	}
+
+	return sched->quantum;
+}
+
+/*
+ * uthread_interactive - Check if adaptive mode shortened a thread's slices
+ */
+static bool uthread_interactive(uthread_tcb *thread)
+{
+	return sched->adaptive && thread->adaptQuantum != 0 &&
+	       thread->adaptQuantum < sched->quantum;
+}
+
+/*
+ * uthread_burst_end - Account for a thread being switched out
+ * @thread: Thread that stops running
+ * @voluntary: true if it yielded or blocked, false if it was preempted
+ *
+ * A voluntary stop ends the thread's current burst, whose length goes into the
+ * average that adaptive mode sizes the thread's time slices from.
+ */
+static void uthread_burst_end(uthread_tcb *thread, bool voluntary)
+{
+	thread->switches++;
+	sched->stats.switches++;
+
+	if (!voluntary) {
+		thread->preemptions++;
+		sched->stats.preemptions++;
+		return;
+	}
+
+	uint64_t burst = thread->runtime - thread->burstStart;
+	thread->burstStart = thread->runtime;
+
+	if (thread->avgBurst == 0) {
+		thread->avgBurst = burst;
+	} else {
+		thread->avgBurst += (burst >> UTHREAD_ADAPT_EWMA_SHIFT) -
+				    (thread->avgBurst >> UTHREAD_ADAPT_EWMA_SHIFT);
+	}
+
+	// Enough room for a typical burst, without letting a thread that usually
+	// stops early hog the CPU when it doesn't
+	uint64_t quantum = 2 * thread->avgBurst / 1000;
+	uint64_t shortest = sched->quantum / UTHREAD_ADAPT_MIN_DIV;
+
+	if (quantum < shortest) {
+		quantum = shortest;
+	}
+	if (quantum > sched->quantum) {
+		quantum = sched->quantum;
+	}
+	thread->adaptQuantum = quantum != 0 ? quantum : 1;
+}
+
+/*
+ * uthread_burst_exhausted - Lengthen time slices of a CPU-bound thread
+ * @thread: Running thread, interrupted by a timer tick
+ *
+ * Ticks also fire at the end of other threads' time slices, so a thread only
+ * counts as CPU-bound once its current burst is at least as long as its slice.
+ */
+static void uthread_burst_exhausted(uthread_tcb *thread)
+{
+	uint64_t quantum = uthread_quantum(thread);
+	uint64_t longest = (uint64_t) sched->quantum * UTHREAD_ADAPT_MAX_MULT;
+
+	if (thread->runtime - thread->burstStart < quantum * 1000) {
+		return;
+	}
+
+	// Slice may have been capped while interactive threads were waiting
+	if (thread->adaptQuantum > quantum) {
+		quantum = thread->adaptQuantum;
+	}
+	quantum *= 2;
+	if (quantum > longest) {
+		quantum = longest;
+	}
+	if (quantum > UINT32_MAX) {
+		quantum = UINT32_MAX;
+	}
+	thread->adaptQuantum = quantum;
+}
+
+/*
+ * uthread_timer_update - Set timer according to currently running thread
+ * @restart: Whether the running thread starts a new time slice, rather than
+ *	going on with the current one (see preempt_set_quantum())
+ *
+ * In tickless mode, the timer is stopped while no other thread is ready to run,
+ * as there would be nothing to preempt the running thread for.
+ */
+static void uthread_timer_update(bool restart)
+{
+	unsigned int quantum = uthread_quantum(sched->runningThread);
+
+	if (sched->tickless &&
+	    (sched->readyCount == 0 || sched->runningThread == sched->idleThread)) {
+		quantum = 0;
+	}
+
+	preempt_set_quantum(&sched->timer, quantum, restart);
+}
+
+/*
+ * uthread_ready_push - Hand ready thread over to the scheduling policy
+ */
+static void uthread_ready_push(uthread_tcb *thread, int reason)
+{
+	sched->policy->enqueue(sched->runQueue, thread, reason);
+	sched->readyCount++;
+
+	// Running thread now has competition, restart timer if it was stopped,
+	// or shorten its time slice if it was lengthened
+	thread->interactive = uthread_interactive(thread);
+	if (thread->interactive) {
+		sched->interactiveCount++;
+	}
+	if (sched->runningThread != NULL && thread != sched->runningThread &&
+	    ((sched->tickless && sched->readyCount == 1) ||
+	     (thread->interactive && sched->interactiveCount == 1))) {
+		uthread_timer_update(false);
+	}
+}
+
+/*
+ * uthread_ready_dequeued - Update counters once a thread left the policy
+ */
+static void uthread_ready_dequeued(uthread_tcb *thread)
+{
+	sched->readyCount--;
+	if (thread->interactive) {
+		sched->interactiveCount--;
+	}
+}
+
+/*
+ * uthread_ready_pop - Get next thread to run from the scheduling policy
+ *
+ * Return: Pointer to thread's TCB, or NULL if no thread is ready
+ */
+static uthread_tcb *uthread_ready_pop(void)
+{
+	uthread_tcb* thread = sched->policy->pick_next(sched->runQueue);
+
+	if (thread != NULL) {
+		uthread_ready_dequeued(thread);
+	}
+
+	return thread;
+}
+
+/*
+ * uthread_ready_remove - Take given ready thread away from the policy
+ */
+static void uthread_ready_remove(uthread_tcb *thread)
+{
+	sched->policy->remove(sched->runQueue, thread);
+	uthread_ready_dequeued(thread);
+}
+
+/*
+ * uthread_ctx_prepare - Initialize context of a thread about to run first time
+ *
+ * Threads created in a batch get their context set up lazily, see
+ * uthread_create_batch().
+ */
+static void uthread_ctx_prepare(uthread_tcb *thread)
+{
+	if (thread->func == NULL) {
+		return;
+	}
+
+	if (stack_usage_enabled()) {
+		stack_usage_fill(thread->stack);
+	}
+
+	// Can't fail, the context is copied from one that could be captured
+	uthread_ctx_init_from(&thread->context, &thread->batch->model,
+			      thread->stack, thread->func, thread->arg);
+	thread->func = NULL;
+}
+
+/*
+ * uthread_resume - Switch from a thread to another
+ * @prev: Thread to save
+ * @next: Thread to resume
+ */
+static void uthread_resume(uthread_tcb *prev, uthread_tcb *next)
+{
+	// Thread without a stack of its own
+	if (next->stack == NULL) {
+		shared_stack_switch(&prev->context, next);
+		return;
+	}
+
+	uthread_ctx_prepare(next);
+	uthread_ctx_switch(&prev->context, &next->context);
+}
+
+static uthread_tcb *uthread_tcb_alloc(uthread_func_t func, void *arg, int node,
+				      uthread_tcb *creator);
+
+/*
+ * uthread_wakeups_drain - Make ready the threads woken up from outside the
+ * scheduler
+ *
+ * Doesn't allocate, so it is also called at each tick, from the timer handler.
+ */
+static void uthread_wakeups_drain(void)
+{
+	struct inbox_node* node;
+
+	while ((node = inbox_pop(&sched->wakeups)) != NULL) {
+		uthread_tcb* thread = container_of(node, uthread_tcb, inboxNode);
+
+		sched->parkedCount--;
+		thread->state = READY;
+		uthread_ready_push(thread, UTHREAD_ENQUEUE_WAKE);
+	}
+}
+
+/*
+ * uthread_inbox_drain - Make ready the threads woken up or requested from
+ * outside the scheduler
+ *
+ * Called at each switch, so that these threads compete with the others for the
+ * next slot. Requests are handled in a single batch.
+ */
+static void uthread_inbox_drain(void)
+{
+	uthread_wakeups_drain();
+
+	uthread_func_t func;
+	void* arg;
+
+	while (sched_spawn_pop(sched, &func, &arg)) {
+		// Dropped if it can't be allocated, there is nobody to tell
+		uthread_tcb* thread = uthread_tcb_alloc(func, arg, -1, NULL);
+		if (thread == NULL) {
+			continue;
+		}
+
+		thread->state = READY;
+		uthread_ready_push(thread, UTHREAD_ENQUEUE_NEW);
+	}
+}
+
+/*
+ * uthread_io_poll - Make ready the threads whose file descriptor became ready
+ * @block: Sleep until something happens, when no thread is ready
+ *
+ * Must be called with preemption disabled.
+ */
+static void uthread_io_poll(bool block)
+{
+	uthread_tcb* threads[UTHREAD_IO_EVENTS];
+	int count = sched_poll(sched, block, threads, UTHREAD_IO_EVENTS);
+
+	for (int i = 0; i < count; i++) {
+		sched->ioWaiting--;
+		threads[i]->state = READY;
+		uthread_ready_push(threads[i], UTHREAD_ENQUEUE_WAKE);
+	}
+}
+
+void uthread_switch(void) {
+	// Disable preempt because going to modify queue
+	preempt_disable();
+
+	// Threads woken up from other kernel threads join the ready ones
+	uthread_inbox_drain();
+
+	// So do threads waiting for I/O, but checking costs a system call
+	if (sched->ioWaiting > 0 &&
+	    ++sched->ioSwitches % UTHREAD_IO_POLL_INTERVAL == 0) {
+		uthread_io_poll(false);
+	}
+
+	// Set running thread to next ready thread, or to idle thread if none
+	sched->runningThread = uthread_ready_pop();
+	if (sched->runningThread == NULL) {
+		sched->runningThread = sched->idleThread;
+	}
+	sched->runningThread->state = RUNNING;
+
+	// Thread gets a new time slice, not what the previous one left of it,
+	// unless that is still most of one
+	sched->runningThread->sliceStart = uthread_clock();
+	uthread_timer_update(true);
+
+	// Resume execution from context of running thread
+	if (sched->runningThread != sched->previousThread) {
+		uthread_resume(sched->previousThread, sched->runningThread);
+	}
+
+	// Enable preempt 
+	preempt_enable();
+}
+
+/*
+ * uthread_requeue - Put running thread back in the ready queue and switch
+ * @reason: Why the thread goes back, UTHREAD_ENQUEUE_YIELD or
+ *	UTHREAD_ENQUEUE_PREEMPT
+ */
+static void uthread_requeue(int reason)
+{
+	// Store current thread into previousThread to remember it
+	sched->previousThread = sched->runningThread;
+
+	// Need to disable it because next steps require accessing global queue,
+	// and until the switch so that a tick cannot requeue the thread twice
+	preempt_disable();
+
+	// Check if previous thread is running
+	if (sched->previousThread->state == RUNNING) {
+		uthread_account();
+
+		// Move running thread back into ready queue (idle thread is only
+		// elected when no other thread is ready)
+		if (sched->previousThread != sched->idleThread) {
+			uthread_burst_end(sched->previousThread, reason == UTHREAD_ENQUEUE_YIELD);
+			uthread_ready_push(sched->previousThread, reason);
+		}
+
+		// Change it back to ready
+		sched->previousThread->state = READY;
+	}
+
+	// Preemption enabled again once this thread is switched back to
+	uthread_switch();
+}
+
+void uthread_yield(void)
+{
+	uthread_requeue(UTHREAD_ENQUEUE_YIELD);
+}
+
+void uthread_tick(void)
+{
+	if (uthread_current() == NULL) {
+		return;
+	}
+	preempt_period_start(&sched->timer);
+
+	// Idle thread only runs while there is nothing else to run
+	if (sched->runningThread == sched->idleThread) {
+		if (sched->readyCount > 0) {
+			uthread_yield();
+		}
+		return;
+	}
+
+	uthread_account();
+	if (sched->adaptive) {
+		uthread_burst_exhausted(sched->runningThread);
+	}
+
+	bool preempt = true;
+	if (sched->policy->on_tick != NULL) {
+		// Threads woken up from other kernel threads must be seen by the
+		// policy, or a more urgent one waits for the running one to yield.
+		// Spawn requests wait for the next switch, as the interrupted code
+		// may be inside malloc()
+		uthread_wakeups_drain();
+		preempt = sched->policy->on_tick(sched->runQueue, sched->runningThread);
+	}
+
+	if (preempt) {
+		uthread_requeue(UTHREAD_ENQUEUE_PREEMPT);
+	} else if (sched->adaptive) {
+		// Keeps running, possibly with a longer time slice
+		uthread_timer_update(false);
+	}
+}
+
+/*
+ * uthread_tls_get - Get the current thread's value for a key
+ *
+ * Return: Value set for @key while it is in use, NULL otherwise
+ */
+static void *uthread_tls_get(uthread_key_t key)
+{
+	struct uthread_tls_slot *slot = &sched->runningThread->tls[key];
+
+	if (!atomic_load(&keys[key].used) ||
+	    slot->generation != atomic_load(&keys[key].generation)) {
+		return NULL;
+	}
+
+	return slot->value;
+}
+
+/*
+ * uthread_tls_destroy - Run the destructors of the current thread's TLS values
+ */
+static void uthread_tls_destroy(void)
+{
+	for (int pass = 0; pass < UTHREAD_DESTRUCTOR_ITERATIONS; pass++) {
+		bool called = false;
+
+		for (uthread_key_t key = 0; key < UTHREAD_KEYS_MAX; key++) {
+			void* value = uthread_tls_get(key);
+			if (value == NULL || keys[key].destructor == NULL) {
+				continue;
+			}
+
+			// Clear slot before calling destructor, which may set it again
+			sched->runningThread->tls[key].value = NULL;
+			keys[key].destructor(value);
+			called = true;
+		}
+
+		if (!called) {
+			break;
+		}
+	}
+}
+
+/*
+ * uthread_deadline_account - Account thread's deadline as met or missed
+ */
+static void uthread_deadline_account(uthread_tcb *thread)
+{
+	if (thread->deadline == 0) {
+		return;
+	}
+
+	uint64_t now = uthread_clock();
+	struct uthread_deadline_stats* stats[] = {&thread->deadlineStats,
+						  &sched->deadlineStats};
+
+	for (int i = 0; i < 2; i++) {
+		if (now <= thread->deadline) {
+			stats[i]->met++;
+		} else {
+			stats[i]->missed++;
+			if (now - thread->deadline > stats[i]->max_lateness) {
+				stats[i]->max_lateness = now - thread->deadline;
+			}
+		}
+	}
+
+	thread->deadline = 0;
+}
+
+void uthread_exit(void)
+{
+	// Release thread-local storage while still running as this thread
+	uthread_tls_destroy();
+
+	// Work is done, in time or not, and last time slice is charged
+	preempt_disable();
+	uthread_arena_release();
+	uthread_deadline_account(sched->runningThread);
+	uthread_account();
+	if (sched->policy->on_block != NULL) {
+		sched->policy->on_block(sched->runQueue, sched->runningThread);
+	}
+
+	// Deepest point reached by the stack, which is left as it is from now on
+	if (stack_usage_enabled() && sched->runningThread->stack != NULL) {
+		stack_usage_record(sched->runningThread->entry, sched->runningThread->stack);
+	}
+
+	sched->previousThread = sched->runningThread;
+
+	// move running thread into exited queue (to be collected by idle thread),
+	// preemption staying disabled since this thread never comes back
+	thread_queue_enqueue(&sched->exitedQueue, sched->previousThread);
+	sched->previousThread->state = EXITED;
+
+	uthread_switch();
+}
+
+/*
+ * uthread_inherit - Set up new thread's scheduling state from its creator
+ * @newThread: Thread to set up
+ * @creator: Thread creating it, or NULL for a thread requested from outside
+ *	the scheduler, which gets the default state
+ */
+static void uthread_inherit(uthread_tcb *newThread, uthread_tcb *creator)
+{
+	newThread->sched = sched;
+
+	// Inherit base priority of the creating thread
+	newThread->basePrio = UTHREAD_PRIO_DEFAULT;
+	if (creator != NULL && creator != sched->idleThread) {
+		newThread->basePrio = creator->basePrio;
+	}
+	newThread->prio = newThread->basePrio;
+
+	// Join group of the creating thread
+	if (creator != NULL) {
+		newThread->group = creator->group;
+		if (newThread->group != NULL) {
+			newThread->group->members++;
+		}
+	}
+
+	// Not runnable until the caller decides where it goes
+	newThread->state = BLOCKED;
+}
+
+/*
+ * uthread_admit - Count threads about to be created
+ * @n: Number of threads
+ * @creator: Thread creating them, whose group they join, see uthread_inherit()
+ *
+ * Policy, and the group the threads join, make room for them beforehand, so
+ * that they can't fail to take them once ready. Threads are counted until
+ * destroyed, or until uthread_admit_cancel() if their creation fails.
+ *
+ * Must be called with preemption disabled.
+ *
+ * Return: 0 in case of success, -1 in case of failure when allocating memory
+ */
+static int uthread_admit(unsigned int n, uthread_tcb *creator)
+{
+	struct uthread_group* group = creator != NULL ? creator->group : NULL;
+
+	if (sched->policy->reserve != NULL &&
+	    sched->policy->reserve(sched->runQueue, sched->threadCount + n)) {
+		return -1;
+	}
+	if (group != NULL && group_reserve(group, group->members + n)) {
+		return -1;
+	}
+
+	sched->threadCount += n;
+
+	return 0;
+}
+
+/*
+ * uthread_admit_cancel - Stop counting threads that couldn't be created
+ */
+static void uthread_admit_cancel(unsigned int n)
+{
+	sched->threadCount -= n;
+}
+
+/*
+ * uthread_tcb_alloc - Allocate a thread without scheduling it
+ * @func: Function to be executed by the thread
+ * @arg: Argument to be passed to the thread
+ * @node: NUMA node to allocate the thread from, or -1 for anywhere
+ * @creator: Thread creating it, see uthread_inherit()
+ *
+ * Must be called with preemption disabled.
+ *
+ * Return: Pointer to new thread's TCB, or NULL in case of failure
+ */
+static uthread_tcb *uthread_tcb_alloc(uthread_func_t func, void *arg, int node,
+				      uthread_tcb *creator)
+{
+	if (uthread_admit(1, creator)) {
+		return NULL;
+	}
+
+	size_t size = UTHREAD_STACK_SIZE + sizeof(uthread_tcb);
+	size_t align = UTHREAD_CACHE_LINE;
+
+	// Memory is placed on nodes by whole pages
+	if (node >= 0) {
+		align = sysconf(_SC_PAGESIZE);
+		size = (size + align - 1) & ~(align - 1);
+	}
+
+	// Allocate memory segment for stack, with thread control block (and
+	// context) on top. Like all allocations of the library, it must not be
+	// interrupted by a tick: the allocator could be reentered by the thread
+	// switched to
+	void* stack = aligned_alloc(align, size);
+	if (stack == NULL) {
+		// Memory allocation error
+		uthread_admit_cancel(1);
+		return NULL;
+	}
+
+	// Before the stack and TCB get touched below
+	affinity_bind(stack, size, node);
+
+	uthread_tcb* newThread = (uthread_tcb*) ((char*) stack + UTHREAD_STACK_SIZE);
+	uthread_tcb_init(newThread, stack);
+	newThread->entry = func;
+
+	if (stack_usage_enabled()) {
+		stack_usage_fill(stack);
+	}
+
+	// Initialize thread execution context
+	int success = uthread_ctx_init(&newThread->context, newThread->stack, func, arg);
+	if (success == -1) {
+		// context creation error
+		free(stack);
+		uthread_admit_cancel(1);
+		return NULL;
+	}
+
+	uthread_inherit(newThread, creator);
+
+	return newThread;
+}
+
+/*
+ * uthread_new_node - Allocate a thread without scheduling it
+ * @func: Function to be executed by the thread
+ * @arg: Argument to be passed to the thread
+ * @node: NUMA node to allocate the thread from, or -1 for anywhere
+ *
+ * Return: Pointer to new thread's TCB, or NULL in case of failure
+ */
+static uthread_tcb *uthread_new_node(uthread_func_t func, void *arg, int node)
+{
+	preempt_disable();
+	uthread_tcb* newThread = uthread_tcb_alloc(func, arg, node, sched->runningThread);
+	preempt_enable();
+
+	return newThread;
+}
+
+struct uthread_tcb *uthread_new(uthread_func_t func, void *arg)
+{
+	return uthread_new_node(func, arg, -1);
+}
+
+/*
+ * uthread_start - Make a new thread ready to run
+ * @newThread: Thread allocated with uthread_new_node()
+ * @handle: Address where the new thread's handle is received, or NULL
+ */
+static void uthread_start(uthread_tcb *newThread, uthread_t *handle)
+{
+	newThread->state = READY;
+
+	// Disable preempt before manipulating data structure queue
+	preempt_disable();
+
+	// Add new thread to ready queue
+	uthread_ready_push(newThread, UTHREAD_ENQUEUE_NEW);
+
+	// Done with modifying queue
+	preempt_enable();
+
+	if (handle != NULL) {
+		*handle = newThread;
+	}
+}
+
+int uthread_create_deadline(uthread_func_t func, void *arg, uint64_t deadline,
+			    uthread_t *handle)
+{
+	uthread_tcb* newThread = uthread_new(func, arg);
+	if (newThread == NULL) {
+		return -1;
+	}
+
+	if (deadline != 0) {
+		newThread->deadline = uthread_clock() + deadline;
+	}
+
+	uthread_start(newThread, handle);
+
+	return 0;
+}
+
+int uthread_create_node(uthread_func_t func, void *arg, int node,
+			uthread_t *handle)
+{
+	uthread_tcb* newThread = uthread_new_node(func, arg, node);
+	if (newThread == NULL) {
+		return -1;
+	}
+
+	uthread_start(newThread, handle);
+
+	return 0;
+}
+
+int uthread_create_handle(uthread_func_t func, void *arg, uthread_t *handle)
+{
+	return uthread_create_deadline(func, arg, 0, handle);
+}
+
+int uthread_create(uthread_func_t func, void *arg)
+{
+	return uthread_create_handle(func, arg, NULL);
+}
+
+int uthread_create_shared(uthread_func_t func, void *arg, uthread_t *handle)
+{
+	// TCB alone, the stack is borrowed whenever the thread runs
+	preempt_disable();
+	uthread_tcb* newThread = NULL;
+	if (shared_stack_init() == 0 && uthread_admit(1, sched->runningThread) == 0) {
+		newThread = aligned_alloc(UTHREAD_CACHE_LINE, sizeof(uthread_tcb));
+		if (newThread == NULL) {
+			uthread_admit_cancel(1);
+		}
+	}
+	preempt_enable();
+	if (newThread == NULL) {
+		// Memory allocation error, or shared stack not available
+		return -1;
+	}
+
+	// Context is initialized once the thread gets the shared stack
+	uthread_tcb_init(newThread, NULL);
+	newThread->func = newThread->entry = func;
+	newThread->arg = arg;
+	uthread_inherit(newThread, sched->runningThread);
+	newThread->state = READY;
+
+	preempt_disable();
+	uthread_ready_push(newThread, UTHREAD_ENQUEUE_NEW);
+	preempt_enable();
+
+	if (handle != NULL) {
+		*handle = newThread;
+	}
+
+	return 0;
+}
+
+int uthread_create_batch(unsigned int n, uthread_func_t func, void *args[],
+			 uthread_t handles[])
+{
+	if (n == 0) {
+		return 0;
+	}
+
+	// One block for everything: header, TCBs, then stacks. Unlike with
+	// uthread_new(), TCBs are kept together so that setting them up touches
+	// as few pages as possible
+	size_t header = (sizeof(struct uthread_batch) + UTHREAD_CACHE_LINE - 1) &
+		~(size_t) (UTHREAD_CACHE_LINE - 1);
+	size_t slot = UTHREAD_STACK_SIZE + sizeof(uthread_tcb);
+	if ((SIZE_MAX - header) / slot < n) {
+		return -1;
+	}
+
+	// Pages are only touched when used, so stack space costs nothing until
+	// threads run
+	preempt_disable();
+	struct uthread_batch* batch = NULL;
+	if (uthread_admit(n, sched->runningThread) == 0) {
+		batch = aligned_alloc(UTHREAD_CACHE_LINE, header + n * slot);
+		if (batch == NULL) {
+			uthread_admit_cancel(n);
+		}
+	}
+	preempt_enable();
+	if (batch == NULL) {
+		// Memory allocation error
+		return -1;
+	}
+
+	uthread_tcb* threads = (uthread_tcb*) ((char*) batch + header);
+	char* stacks = (char*) (threads + n);
+
+	// Context state is only captured once, and copied into each thread's
+	// context when it first runs so that its stack isn't touched before.
+	// Nothing has been made visible yet, so failure only needs to free
+	if (uthread_ctx_init(&batch->model, stacks, func, NULL) == -1) {
+		preempt_disable();
+		free(batch);
+		uthread_admit_cancel(n);
+		preempt_enable();
+		return -1;
+	}
+
+	batch->live = n;
+	for (unsigned int i = 0; i < n; i++) {
+		uthread_tcb* thread = &threads[i];
+
+		uthread_tcb_init(thread, stacks + (size_t) i * UTHREAD_STACK_SIZE);
+		thread->batch = batch;
+		thread->func = thread->entry = func;
+		thread->arg = args != NULL ? args[i] : NULL;
+		uthread_inherit(thread, sched->runningThread);
+		thread->state = READY;
+
+		if (handles != NULL) {
+			handles[i] = thread;
+		}
+	}
+
+	// All threads become ready at once
+	preempt_disable();
+	for (unsigned int i = 0; i < n; i++) {
+		uthread_ready_push(&threads[i], UTHREAD_ENQUEUE_NEW);
+	}
+	preempt_enable();
+
+	return 0;
+}
+
+void uthread_destroy(uthread_tcb* thread) {
+	// Memory of a thread that didn't exit
+	arena_release(&thread->arena, &sched->arenaCache);
+
+	// Leave thread group, and the policy's count
+	if (thread->group != NULL) {
+		thread->group->members--;
+	}
+	sched->threadCount--;
+
+	// Thread only has its TCB, and a copy of its stack
+	if (thread->stack == NULL) {
+		shared_stack_release(thread);
+		free(thread);
+		return;
+	}
+
+	// Memory shared with other threads goes once they are all gone
+	if (thread->batch != NULL) {
+		if (--thread->batch->live == 0) {
+			free(thread->batch);
+		}
+		return;
+	}
+
+	// Deallocate stack, along with the thread and its context
+	free(thread->stack);
+}
+
+/*
+ * uthread_collect - Deallocate the threads in the exited queue
+ */
+static void uthread_collect(void)
+{
+	uthread_tcb* thread;
+
+	while ((thread = thread_queue_dequeue(&sched->exitedQueue)) != NULL) {
+		uthread_destroy(thread);
+	}
+}
+
+/*
+ * uthread_sched_waiting - Check if threads can still come from outside
+ */
+static bool uthread_sched_waiting(void)
+{
+	// Requests are counted as being made until queued, so the count is
+	// checked before the queue
+	return sched->parkedCount > 0 || sched->ioWaiting > 0 ||
+	       atomic_load(&sched->spawning) > 0 ||
+	       !inbox_empty(&sched->spawns) ||
+	       (sched->keepalive && !atomic_load(&sched->stopped));
+}
+
+void uthread_idle(void) {
+	do  {
+		// Yield to next thread
+		uthread_yield();
+	
+		// Clear threads in exited queue
+		preempt_disable();
+		uthread_collect();
+		preempt_enable();
+
+		// Nothing to run until a file descriptor becomes ready, a parked
+		// thread is woken up, or a thread is requested, which can only
+		// come from another kernel thread or a signal handler
+		if (sched->readyCount == 0 && uthread_sched_waiting()) {
+			preempt_disable();
+			uthread_io_poll(true);
+			preempt_enable();
+		}
+
+	// While threads can still run
+	} while (sched->readyCount > 0 || uthread_sched_waiting());
+}
+
+/*
+ * uthread_queues_destroy - Deallocate scheduler queues
+ */
+static void uthread_queues_destroy(void)
+{
+	if (sched->runQueue != NULL) {
+		sched->policy->fini(sched->runQueue);
+		sched->runQueue = NULL;
+	}
+
+	arena_cache_fini(&sched->arenaCache);
+}
+
+/*
+ * uthread_sched_leave - Detach scheduler from the calling kernel thread
+ * @owned: Whether the scheduler was created by uthread_run_config(), and only
+ *	lives as long as it runs
+ */
+static void uthread_sched_leave(bool owned)
+{
+	preempt_stop(&sched->timer);
+	atomic_store(&sched->running, false);
+	if (owned) {
+		sched_destroy(sched);
+	}
+	sched = NULL;
+
+	affinity_stop();
+}
+
+void uthread_config_init(struct uthread_config *config)
+{
+	config->preempt = false;
+	config->policy = &uthread_policy_fifo;
+	config->quantum = UTHREAD_QUANTUM_DEFAULT;
+	config->tickless = false;
+	config->adaptive = false;
+	config->stack_usage = false;
+	config->cpus = NULL;
+	config->numa_node = -1;
+	config->sched = NULL;
+}
+
+int uthread_run(bool preempt, uthread_func_t func, void *arg)
+{
+	struct uthread_config config;
+
+	uthread_config_init(&config);
+	config.preempt = preempt;
+
+	return uthread_run_config(&config, func, arg);
+}
+
+int uthread_run_config(const struct uthread_config *config,
+		       uthread_func_t func, void *arg)
+{
+	if (config == NULL || config->policy == NULL || config->quantum == 0 ||
+	    config->numa_node < -1 || sched != NULL) {
+		return -1;
+	}
+
+	// Threads' memory, and the scheduler's, is allocated once the kernel
+	// thread is in place
+	if (affinity_start(config->cpus, config->numa_node)) {
+		return -1;
+	}
+
+	// Scheduler created for this run, unless one is given, which must not be
+	// running on another kernel thread
+	bool owned = config->sched == NULL;
+	struct uthread_sched* newSched = owned ? sched_create(false) : config->sched;
+	if (newSched == NULL || atomic_exchange(&newSched->running, true)) {
+		affinity_stop();
+		return -1;
+	}
+	sched = newSched;
+
+	// Should be called when uthread library is setting up preemption
+	preempt_start(&sched->timer, config->preempt);
+
+	int success = 0;
+
+	// Accessing scheduler's queues, so remember to disable preempt
+	preempt_disable();
+
+	// Run queue for ready threads, managed by scheduling policy
+	sched->policy = config->policy;
+	sched->runQueue = sched->policy->init();
+	sched->readyCount = 0;
+	sched->threadCount = 0;
+	sched->interactiveCount = 0;
+	memset(&sched->deadlineStats, 0, sizeof(sched->deadlineStats));
+	memset(&sched->stats, 0, sizeof(sched->stats));
+	sched->quantum = config->quantum;
+	sched->tickless = config->tickless;
+	sched->adaptive = config->adaptive;
+	stack_usage_start(config->stack_usage);
+
+	// Queue for exited threads
+	thread_queue_init(&sched->exitedQueue);
+
+	// Enable preempt after done with queue
+	preempt_enable();
+
+	// Threads only woken up through the inbox, or by I/O
+	sched->parkedCount = 0;
+	sched->ioWaiting = 0;
+	sched->ioSwitches = 0;
+
+	// Failure to initalize the run queue
+	if (sched->runQueue == NULL) {
+		uthread_queues_destroy();
+		uthread_sched_leave(owned);
+		return -1;
+	}
+
+ 	// TCB for idle thread (context overwritten on switch), which is never in
+ 	// the ready queues
+	sched->idleThread = uthread_new(NULL, NULL);
+	
+	if (sched->idleThread == NULL) {
+		// Thread create error
+		uthread_queues_destroy();
+		uthread_sched_leave(owned);
+		return -1;
+	}
+	// Set to running thread to facilitate context switch
+	sched->runningThread = sched->idleThread;
+	sched->runningThread->state = RUNNING;
+	
+	success = uthread_create(func, arg); // Add initial thread to queue
+	if (success == -1) {
+		// Thread create error
+		uthread_destroy(sched->idleThread);
+		sched->runningThread = sched->idleThread = NULL;
+		uthread_queues_destroy();
+		uthread_sched_leave(owned);
+		return -1;
+	}
+
+	// Begin thread execution
+	uthread_idle();
+
+	// Collect threads that exited last
+	uthread_collect();
+
+	uthread_destroy(sched->idleThread);
+	sched->runningThread = sched->idleThread = NULL;
+
+	// Destroying queue 
+	uthread_queues_destroy();
+	shared_stack_fini();
+
+	if (stack_usage_enabled()) {
+		uthread_stack_report();
+	}
+
+	// Call this function before uthread_run() returns
+	// to get old signal alarm and timer, and placement
+	uthread_sched_leave(owned);
+
+	return 0;
+}
 
 /*
- * uthread_tcb - Internal representation of threads called TCB (Thread Control
- * Block)
+ * uthread_blocking - Let a pool know that one of its workers blocks in a job
+ * @thread: Thread about to block
+ *
+ * Another worker may be made ready to take over the pool's other jobs.
  */
-struct uthread_tcb {
-	state_t state;
-	uthread_ctx_t* context;
-	void* stack;
-};
-typedef struct uthread_tcb uthread_tcb;
+static void uthread_blocking(uthread_tcb *thread)
+{
+	if (thread->poolWorker == NULL) {
+		return;
+	}
 
-queue_t readyQueue;
-uthread_tcb* runningThread;
-uthread_tcb* previousThread;
-queue_t exitedQueue;
+	uthread_tcb* spare = pool_worker_block(thread->poolWorker);
+	if (spare != NULL) {
+		spare->state = READY;
+		uthread_ready_push(spare, UTHREAD_ENQUEUE_NEW);
+	}
+}
 
-struct uthread_tcb *uthread_current(void)
+void uthread_block(void)
 {
-	return runningThread;
+	// set previous to thread (but don't put in any queue)
+	// set status of active thread to blocked -- right order from previous line?
+	// call context switch
+
+	// Kept disabled until the switch, so that a tick cannot put the blocked
+	// thread back in the ready queue
+	preempt_disable();
+
+	sched->previousThread = sched->runningThread;
+	sched->previousThread->state = BLOCKED;
+	// in semaphore blocked queue, don't add to ready queue
+
+	// Let policy know the thread stopped before the end of its time slice
+	uthread_account();
+	uthread_burst_end(sched->previousThread, true);
+	if (sched->policy->on_block != NULL) {
+		sched->policy->on_block(sched->runQueue, sched->previousThread);
+	}
+	uthread_blocking(sched->previousThread);
+
+	// Part of yielding process
+	uthread_switch(); 
 }
 
-void uthread_switch(void) {
-	// Disable preempt because going to modify queue
+/*
+ * uthread_transfer - Switch directly to a given thread
+ * @target: Thread to resume, either ready or blocked
+ * @state: State the current thread is left in, READY or BLOCKED
+ * @reason: Why the current thread is put back in the ready queue,
+ *	UTHREAD_ENQUEUE_YIELD or UTHREAD_ENQUEUE_PREEMPT
+ *
+ * The current thread is only put back in the ready queue if @state is READY.
+ */
+static void uthread_transfer(uthread_tcb *target, state_t state, int reason)
+{
+	// Queue and thread states are about to change
 	preempt_disable();
 
-	// Set running thread to next ready thread
-	queue_dequeue(readyQueue, (void**) &runningThread);
-	runningThread->state = RUNNING;
+	uthread_account();
 
-	// Resume execution from context of running thread
-	uthread_ctx_switch(previousThread->context, runningThread->context);
+	sched->previousThread = sched->runningThread;
+	sched->previousThread->state = state;
+	uthread_burst_end(sched->previousThread, state == BLOCKED ||
+			  reason == UTHREAD_ENQUEUE_YIELD);
+	if (state == READY) {
+		uthread_ready_push(sched->previousThread, reason);
+	} else {
+		if (sched->policy->on_block != NULL) {
+			sched->policy->on_block(sched->runQueue, sched->previousThread);
+		}
+		uthread_blocking(sched->previousThread);
+	}
+
+	// Take target out of the ready queue, it won't be dequeued there
+	if (target->state == READY) {
+		uthread_ready_remove(target);
+	}
+
+	sched->runningThread = target;
+	sched->runningThread->state = RUNNING;
+	sched->runningThread->sliceStart = uthread_clock();
+	uthread_timer_update(true);
+
+	// Resume target without going through the ready queue
+	uthread_resume(sched->previousThread, sched->runningThread);
 
-	// Enable preempt 
 	preempt_enable();
 }
 
-void uthread_yield(void)
+int uthread_switch_to(uthread_t target)
 {
-	// Store current thread into previousThread to remember it
-	previousThread = runningThread;
+	// Threads of other schedulers aren't in this scheduler's ready queue
+	if (target == NULL || uthread_current() == NULL || target->sched != sched ||
+	    target == sched->runningThread || target->state != READY) {
+		return -1;
+	}
 
-	// Check if previous thread is running
-	if (previousThread->state == RUNNING) {
-		
-		// Need to disable it because next step requires accessing global queue
-		preempt_disable();
+	uthread_transfer(target, READY, UTHREAD_ENQUEUE_YIELD);
 
-		// Move running thread back into ready queue
-		queue_enqueue(readyQueue, previousThread);
+	return 0;
+}
 
-		// Change it back to ready
-		previousThread->state = READY;
+void uthread_block_to(struct uthread_tcb *target)
+{
+	uthread_transfer(target, BLOCKED, UTHREAD_ENQUEUE_YIELD);
+}
 
-		// Done with modifying global data structure
+uthread_sched_t uthread_sched_self(void)
+{
+	return uthread_current() != NULL ? sched : NULL;
+}
+
+void uthread_park(void)
+{
+	// Kept disabled until the switch, so that the inbox is only drained once
+	// the thread is blocked
+	preempt_disable();
+
+	// Woken up before it got to park
+	int expected = UTHREAD_PARK_NONE;
+	if (!atomic_compare_exchange_strong(&sched->runningThread->parkState, &expected,
+					    UTHREAD_PARK_PARKED)) {
+		atomic_store(&sched->runningThread->parkState, UTHREAD_PARK_NONE);
 		preempt_enable();
+		return;
 	}
 
-	uthread_switch();
+	sched->parkedCount++;
+	uthread_block();
+
+	// Wake-ups received since the one that got the thread here are merged
+	// into it
+	atomic_store(&sched->runningThread->parkState, UTHREAD_PARK_NONE);
 }
 
-void uthread_exit(void)
+int uthread_unpark(uthread_t thread)
 {
-	previousThread = runningThread;
+	if (thread == NULL) {
+		return -1;
+	}
 
-	// move running thread into exited queue (to be collected by idle thread)
-	queue_enqueue(exitedQueue, previousThread);
-	previousThread->state = EXITED;
+	// Only the wake-up that finds the thread parked gets it through the
+	// inbox, later ones are merged
+	if (atomic_exchange(&thread->parkState, UTHREAD_PARK_WOKEN) == UTHREAD_PARK_PARKED) {
+		// Thread may run, and exit, as soon as it is in the inbox
+		struct uthread_sched* threadSched = thread->sched;
 
-	uthread_switch();
+		inbox_push(&threadSched->wakeups, &thread->inboxNode);
+		sched_kick(threadSched);
+	}
+
+	return 0;
 }
 
-int uthread_create(uthread_func_t func, void *arg)
+/*
+ * uthread_wake_boost - Check if woken thread should run right away
+ * @thread: Thread being woken up
+ *
+ * In adaptive mode, a thread whose time slices got shorter than the default
+ * preempts a running thread whose slices got longer, unless the policy has its
+ * own rule for wake-up preemption or @thread has a lower priority.
+ */
+static bool uthread_wake_boost(uthread_tcb *thread)
 {
-	// Allocate space for thread control block
-	uthread_tcb* newThread = (uthread_tcb*) malloc(sizeof(uthread_tcb));
-	if (newThread == NULL) {
-		// Memory allocation error
-		return -1;
+	if (!sched->adaptive || sched->policy->on_wake != NULL ||
+	    sched->runningThread == sched->idleThread) {
+		return false;
 	}
 
-	/* Create thread */
+	return uthread_interactive(thread) &&
+	       sched->runningThread->adaptQuantum > sched->quantum &&
+	       thread->prio <= sched->runningThread->prio;
+}
 
-	// Allocate space for thread context
-	uthread_ctx_t* context = (uthread_ctx_t*) malloc(sizeof(uthread_ctx_t));
-	if (context == NULL) {
-		// Memory allocation error
-		free(newThread);
-		return -1;
-	} else {
-		newThread->context = context;
+void uthread_unblock(struct uthread_tcb *uthread)
+{
+	// Check if thread is still blocked
+	if (uthread->state == BLOCKED) {
+		// Change state of thread to ready
+		uthread->state = READY;
 	}
 
-	// Allocate memory segment for stack
-	void* stack = uthread_ctx_alloc_stack();
-	if (stack == NULL) {
-		// Memory allocation error
-		free(newThread);
-		return -1;
-	} else {
-		newThread->stack = stack;
+	// Accessing global queue, so disable
+	preempt_disable();
+
+	// Policy may want the woken thread to run before the current one
+	bool preempt = false;
+	if (sched->policy->on_wake != NULL) {
+		preempt = sched->policy->on_wake(sched->runQueue, uthread, sched->runningThread);
 	}
 
-	// Initialize thread execution context
-	int success = uthread_ctx_init(newThread->context, newThread->stack, func, arg);
-	if (success == -1) {
-		// context creation error
-		uthread_ctx_destroy_stack(newThread->stack);
-		free(newThread);
-		return -1;
+	// Move unblocked thread back into ready queue
+	uthread_ready_push(uthread, UTHREAD_ENQUEUE_WAKE);
+
+	// Thread that only runs briefly gets in ahead of a CPU-bound one
+	if (uthread_wake_boost(uthread)) {
+		uthread_transfer(uthread, READY, UTHREAD_ENQUEUE_PREEMPT);
+		return;
 	}
 
-	newThread->state = READY;
+	// Enable preempt after modifying queue
+	preempt_enable();
 
-	// Disable preempt before manipulating data structure queue
+	if (preempt && sched->runningThread != sched->idleThread) {
+		uthread_requeue(UTHREAD_ENQUEUE_PREEMPT);
+	}
+}
+
+void uthread_update(struct uthread_tcb *thread,
+		    void (*update)(struct uthread_tcb *thread, void *arg), void *arg)
+{
 	preempt_disable();
 
-	// Add new thread to ready queue
-	queue_enqueue(readyQueue, newThread);
+	// Ready thread is taken out while its scheduling parameters change
+	bool ready = thread->state == READY && thread != sched->idleThread;
+	if (ready) {
+		uthread_ready_remove(thread);
+	}
+
+	update(thread, arg);
+
+	if (ready) {
+		uthread_ready_push(thread, UTHREAD_ENQUEUE_REQUEUE);
+	}
 
-	// Done with modifying queue
 	preempt_enable();
-	
-	return 0;
 }
 
-void uthread_destroy(uthread_tcb* thread) {
-	// Deallocate stack
-	uthread_ctx_destroy_stack(thread->stack);
-	
-	// Deallocate context
-	free(thread->context);
-	
-	// Deallocate thread
-	free(thread);
+static void uthread_update_prio(uthread_tcb *thread, void *arg)
+{
+	thread->basePrio = thread->prio = *(int*) arg;
 }
 
-static void uthread_remove(queue_t q, void *data) {
-    uthread_tcb* thread = (uthread_tcb*) data;
+int uthread_setprio(uthread_t thread, int prio)
+{
+	if (thread == NULL || prio < UTHREAD_PRIO_HIGHEST || prio > UTHREAD_PRIO_LOWEST) {
+		return -1;
+	}
 
-	// Clear thread
-	uthread_destroy(thread);
+	uthread_update(thread, uthread_update_prio, &prio);
 
-	// Remove from queue
-	queue_delete(q, data);
+	return 0;
 }
 
-void uthread_idle(void) {
-	do  {
-		// Yield to next thread
-		uthread_yield();
-	
-		// Clear threads in exited queue
-		queue_iterate(exitedQueue, uthread_remove);
+static void uthread_update_deadline(uthread_tcb *thread, void *arg)
+{
+	uint64_t deadline = *(uint64_t*) arg;
 
-	} while (queue_length(readyQueue) > 0); // While there are still ready threads in queue
+	uthread_deadline_account(thread);
+	if (deadline != 0) {
+		thread->deadline = uthread_clock() + deadline;
+	}
 }
 
-int uthread_run(bool preempt, uthread_func_t func, void *arg)
+int uthread_set_deadline(uthread_t thread, uint64_t deadline)
 {
-	// Should be called when uthread library is setting up preemption
-	preempt_start(preempt);
+	if (thread == NULL) {
+		return -1;
+	}
+
+	uthread_update(thread, uthread_update_deadline, &deadline);
+
+	return 0;
+}
+
+static void uthread_update_quantum(uthread_tcb *thread, void *arg)
+{
+	thread->quantum = *(unsigned int*) arg;
+}
+
+int uthread_set_quantum(uthread_t thread, unsigned int quantum)
+{
+	if (thread == NULL) {
+		return -1;
+	}
 
-	int success;
+	uthread_update(thread, uthread_update_quantum, &quantum);
 
-	// Accessing global queue, so remember to disable preempt
+	// Running thread's new time slice applies right away
 	preempt_disable();
+	uthread_timer_update(false);
+	preempt_enable();
 
-	// Queue for ready threads
-	readyQueue = queue_create(); 
+	return 0;
+}
 
-	// Enable preempt after done with queue
+int uthread_set_sched_quantum(unsigned int quantum)
+{
+	if (quantum == 0 || uthread_current() == NULL) {
+		return -1;
+	}
+
+	preempt_disable();
+	sched->quantum = quantum;
+	uthread_timer_update(false);
 	preempt_enable();
 
-	// Failure to initalize the queue
-	if (readyQueue == NULL) {
+	return 0;
+}
+
+int uthread_deadline_stats(uthread_t thread, struct uthread_deadline_stats *stats)
+{
+	if (stats == NULL) {
 		return -1;
 	}
 
- 	// Add TCB for idle thread to queue (context overwritten on switch)
-	success = uthread_create(NULL, NULL);
-	
-	if (success == -1) {
-		// Thread create error
-		queue_destroy(readyQueue);
+	*stats = thread != NULL ? thread->deadlineStats : sched->deadlineStats;
+
+	return 0;
+}
+
+int uthread_stats(uthread_t thread, struct uthread_stats *stats)
+{
+	if (stats == NULL) {
 		return -1;
 	}
-	// Set to running thread to facilitate context switch
-	queue_dequeue(readyQueue, (void**) &runningThread); 
-	runningThread->state = RUNNING;
-	
-	success = uthread_create(func, arg); // Add initial thread to queue
-	if (success == -1) {
-		// Thread create error
-		uthread_destroy(runningThread);
-		queue_destroy(readyQueue);
+
+	if (thread == NULL) {
+		*stats = sched->stats;
+		stats->quantum = sched->quantum;
+		return 0;
+	}
+
+	stats->runtime = thread->runtime;
+	stats->switches = thread->switches;
+	stats->preemptions = thread->preemptions;
+	stats->avg_burst = thread->avgBurst;
+	stats->quantum = uthread_quantum(thread);
+
+	return 0;
+}
+
+int uthread_getprio(uthread_t thread)
+{
+	if (thread == NULL) {
 		return -1;
 	}
 
-	// Queue for exited threads
-	exitedQueue = queue_create(); 
+	return thread->basePrio;
+}
 
-	// Begin thread execution
-	uthread_idle();
+void **uthread_policy_data(uthread_t thread)
+{
+	if (thread == NULL) {
+		return NULL;
+	}
 
-	// Destroying queue 
-	queue_destroy(readyQueue);
-	queue_destroy(exitedQueue);
+	return &thread->policyData;
+}
 
-	// Call this function before uthread_run() returns
-	// to get old signal alarm and timer 
-	preempt_stop();
+int uthread_key_create(uthread_key_t *key, void (*destructor)(void *value))
+{
+	if (key == NULL) {
+		return -1;
+	}
+
+	// Key table is shared by all threads of all schedulers, a key is taken
+	// by whoever marks it used first
+	for (uthread_key_t k = 0; k < UTHREAD_KEYS_MAX; k++) {
+		bool used = false;
+
+		if (atomic_compare_exchange_strong(&keys[k].used, &used, true)) {
+			keys[k].destructor = destructor;
+
+			*key = k;
+			return 0;
+		}
+	}
+
+	// No key left
+	return -1;
+}
+
+int uthread_key_delete(uthread_key_t key)
+{
+	if (key >= UTHREAD_KEYS_MAX || !keys[key].used) {
+		return -1;
+	}
+
+	// Values set for the key are left behind, for good
+	keys[key].destructor = NULL;
+	atomic_fetch_add(&keys[key].generation, 1);
+	atomic_store(&keys[key].used, false);
 
 	return 0;
 }
 
-void uthread_block(void)
+void *uthread_getspecific(uthread_key_t key)
 {
-	// set previous to thread (but don't put in any queue)
-	// set status of active thread to blocked -- right order from previous line?
-	// call context switch
+	if (key >= UTHREAD_KEYS_MAX || uthread_current() == NULL) {
+		return NULL;
+	}
 
-	previousThread = runningThread;
-	previousThread->state = BLOCKED;
-	// in semaphore blocked queue, don't add to ready queue
+	return uthread_tls_get(key);
+}
 
-	// Part of yielding process
-	uthread_switch(); 
+int uthread_setspecific(uthread_key_t key, void *value)
+{
+	if (key >= UTHREAD_KEYS_MAX || !keys[key].used || uthread_current() == NULL) {
+		return -1;
+	}
+
+	struct uthread_tls_slot *slot = &sched->runningThread->tls[key];
+
+	slot->value = value;
+	slot->generation = atomic_load(&keys[key].generation);
+
+	return 0;
 }
 
-void uthread_unblock(struct uthread_tcb *uthread)
+void *uthread_alloc(size_t size)
 {
-	// Check if thread is still blocked
-	if (uthread->state == BLOCKED) {
-		// Change state of thread to ready
-		uthread->state = READY;
+	if (size == 0 || uthread_current() == NULL) {
+		return NULL;
 	}
 
-	// Accessing global queue, so disable
-	preempt_disable();
+	return arena_alloc(&sched->runningThread->arena, &sched->arenaCache, size);
+}
 
-	// Move unblocked thread back into ready queue
-	queue_enqueue(readyQueue, uthread);
+void uthread_arena_release(void)
+{
+	arena_release(&sched->runningThread->arena, &sched->arenaCache);
+}
 
-	// Enable preempt after modifying queue
-	preempt_enable();
+void *uthread_get_userdata(void)
+{
+	if (uthread_current() == NULL) {
+		return NULL;
+	}
+
+	return sched->runningThread->userdata;
+}
+
+void uthread_set_userdata(void *data)
+{
+	if (uthread_current() != NULL) {
+		sched->runningThread->userdata = data;
+	}
 }
@@ -2,6 +2,8 @@
 #define _UTHREAD_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /*
  * uthread_func_t - Thread function type
@@ -9,15 +11,36 @@
  */
 typedef void (*uthread_func_t)(void *arg);
 
+/*
+ * uthread_t - Thread handle type
+ *
+ * A handle stays valid until its thread has exited and been collected by the
+ * library, which can happen as soon as the thread exits.
+ */
+typedef struct uthread_tcb *uthread_t;
+
+/*
+ * uthread_sched_t - Scheduler handle type
+ *
+ * Lets other kernel threads hand threads over to a running scheduler (see
+ * uthread_spawn_remote()).
+ */
+typedef struct uthread_sched *uthread_sched_t;
+
 /*
  * uthread_run - Run the multithreading library
  * @preempt: Preemption enable
  * @func: Function of the first thread to start
  * @arg: Argument to be passed to the first thread
  *
- * This function should only be called by the process' original execution
- * thread. It starts the multithreading scheduling library, and becomes the
- * "idle" thread. It returns once all the threads have finished running.
+ * This function can be called by any kernel thread that isn't already running
+ * it. It starts the multithreading scheduling library, and becomes the "idle"
+ * thread. It returns once all the threads have finished running.
+ *
+ * Each kernel thread calling it runs a scheduler of its own, which shares no
+ * state with the others: threads stay on the kernel thread they were created
+ * on, and semaphores and other objects of the library must only be used by the
+ * threads of a single scheduler.
  *
  * If @preempt is `true`, then preemptive scheduling is enabled.
  *
@@ -26,6 +49,73 @@ typedef void (*uthread_func_t)(void *arg);
  */
 int uthread_run(bool preempt, uthread_func_t func, void *arg);
 
+/*
+ * UTHREAD_QUANTUM_DEFAULT - Default length of time slices (in microseconds)
+ */
+#define UTHREAD_QUANTUM_DEFAULT 10000
+
+/*
+ * struct uthread_config - Configuration of the multithreading library
+ * @preempt: Preemption enable
+ * @policy: Scheduling policy (see policy.h)
+ * @quantum: Length of time slices, in microseconds of CPU time, when
+ *	preemption is enabled
+ * @tickless: Stop the preemption timer while a single thread is able to run,
+ *	instead of interrupting it at the end of every time slice
+ * @adaptive: Tune the time slices of each thread to how long it usually runs
+ *	before yielding or blocking (see uthread_stats())
+ * @stack_usage: Measure how much of its stack each thread used once it exits,
+ *	and print a report when done running (see uthread_stack_usage())
+ * @cpus: CPUs the threads run on, in the kernel's list format (e.g. "0-3,8"),
+ *	or NULL to leave the calling kernel thread where it is
+ * @numa_node: NUMA node whose memory stacks and TCBs are allocated from, and
+ *	whose CPUs the threads run on unless @cpus is set, or -1 for none
+ * @sched: Scheduler created with uthread_sched_create(), which keeps running
+ *	until stopped, or NULL for one that returns once all threads have finished
+ *
+ * A configuration should be initialized with uthread_config_init() before
+ * setting any of its fields, so that fields added later get a default value.
+ */
+struct uthread_policy;
+struct uthread_config {
+	bool preempt;
+	const struct uthread_policy *policy;
+	unsigned int quantum;
+	bool tickless;
+	bool adaptive;
+	bool stack_usage;
+	const char *cpus;
+	int numa_node;
+	uthread_sched_t sched;
+};
+
+/*
+ * uthread_config_init - Initialize configuration with default values
+ * @config: Configuration to initialize
+ *
+ * By default, preemption is disabled, threads are scheduled round-robin in
+ * order of arrival, time slices last UTHREAD_QUANTUM_DEFAULT and the timer
+ * keeps ticking. Time slices are not adaptive, stack usage is not measured,
+ * and threads run wherever the calling kernel thread is allowed to. Another
+ * policy, such as uthread_policy_prio, is chosen by setting @config->policy
+ * afterwards.
+ */
+void uthread_config_init(struct uthread_config *config);
+
+/*
+ * uthread_run_config - Run the multithreading library with a configuration
+ * @config: Configuration to use
+ * @func: Function of the first thread to start
+ * @arg: Argument to be passed to the first thread
+ *
+ * Same as uthread_run(), with every setting taken from @config.
+ *
+ * Return: 0 in case of success, -1 in case of failure (e.g., invalid
+ * configuration, memory allocation, context creation).
+ */
+int uthread_run_config(const struct uthread_config *config,
+		       uthread_func_t func, void *arg);
+
 /*
  * uthread_create - Create a new thread
  * @func: Function to be executed by the thread
@@ -39,6 +129,87 @@ int uthread_run(bool preempt, uthread_func_t func, void *arg);
  */
 int uthread_create(uthread_func_t func, void *arg);
 
+/*
+ * uthread_create_handle - Create a new thread and get its handle
+ * @func: Function to be executed by the thread
+ * @arg: Argument to be passed to the thread
+ * @handle: Address where the new thread's handle is received, or NULL
+ *
+ * Same as uthread_create(), but also returns a handle to the new thread which
+ * can be passed to uthread_switch_to().
+ *
+ * Return: 0 in case of success, -1 in case of failure (e.g., memory allocation,
+ * context creation).
+ */
+int uthread_create_handle(uthread_func_t func, void *arg, uthread_t *handle);
+
+/*
+ * uthread_create_shared - Create a new thread running on the shared stack
+ * @func: Function to be executed by the thread
+ * @arg: Argument to be passed to the thread
+ * @handle: Address where the new thread's handle is received, or NULL
+ *
+ * Same as uthread_create_handle(), but the new thread doesn't get a stack of
+ * its own. It runs on a stack shared with the other threads created this way,
+ * and the part of its stack in use is copied aside when another of them needs
+ * the shared stack. Such threads cost a few kilobytes each while switched out,
+ * so this is meant for large numbers of mostly idle threads with shallow
+ * stacks. Switching between two of them is slower than between normal
+ * threads, and pointers to their stack must not be handed to other threads,
+ * or to helper kernel threads (e.g., as the argument of uthread_offload() or
+ * of the function of a future). The library's own waits (uthread_await*(),
+ * uthread_pool_wait(), uthread_offload(), semaphores, ...) keep nothing on the
+ * stack of the waiting thread, and can be used by these threads.
+ *
+ * Return: 0 in case of success, -1 in case of failure (e.g., memory allocation,
+ * shared stacks not supported on this architecture).
+ */
+int uthread_create_shared(uthread_func_t func, void *arg, uthread_t *handle);
+
+/*
+ * uthread_create_batch - Create many threads at once
+ * @n: Number of threads to create
+ * @func: Function to be executed by every thread
+ * @args: Argument to be passed to each thread, or NULL to pass NULL to all
+ * @handles: Array where the handles of the new threads are received, or NULL
+ *
+ * Same as calling uthread_create_handle() @n times, but the threads are
+ * allocated together and become ready at once, which is much cheaper for large
+ * fan-outs. Their memory is only released once all @n threads have exited and
+ * been collected.
+ *
+ * Return: 0 in case of success, -1 in case of failure (e.g., memory allocation,
+ * context creation), in which case no thread was created.
+ */
+int uthread_create_batch(unsigned int n, uthread_func_t func, void *args[],
+			 uthread_t handles[]);
+
+/*
+ * uthread_create_node - Create a new thread with memory on a NUMA node
+ * @func: Function to be executed by the thread
+ * @arg: Argument to be passed to the thread
+ * @node: NUMA node to allocate the thread's stack and TCB from
+ * @handle: Address where the new thread's handle is received, or NULL
+ *
+ * Same as uthread_create_handle(), with @node as a placement hint: the memory
+ * stays where the system puts it if @node doesn't exist or is full. All
+ * threads run on the kernel thread that called uthread_run(), so the hint
+ * pays off when it runs on @node too (see struct uthread_config).
+ *
+ * Return: 0 in case of success, -1 in case of failure (e.g., memory allocation,
+ * context creation).
+ */
+int uthread_create_node(uthread_func_t func, void *arg, int node,
+			uthread_t *handle);
+
+/*
+ * uthread_self - Get handle of currently running thread
+ *
+ * Return: Handle of the currently running thread, or NULL if called outside of
+ * uthread_run()
+ */
+uthread_t uthread_self(void);
+
 /*
  * uthread_yield - Yield execution
  *
@@ -47,6 +218,85 @@ int uthread_create(uthread_func_t func, void *arg);
  */
 void uthread_yield(void);
 
+/*
+ * uthread_set_quantum - Set length of a thread's time slices
+ * @thread: Handle of thread to modify
+ * @quantum: Length of time slices in microseconds, or 0 to use the
+ *	scheduler's default
+ *
+ * Return: -1 if @thread is NULL. 0 if the quantum of @thread was set.
+ */
+int uthread_set_quantum(uthread_t thread, unsigned int quantum);
+
+/*
+ * uthread_set_sched_quantum - Set default length of time slices
+ * @quantum: Length of time slices in microseconds
+ *
+ * Change at runtime the length of time slices of threads that don't have
+ * their own.
+ *
+ * Return: -1 if @quantum is 0 or if called outside of uthread_run(). 0 if the
+ * default quantum was set.
+ */
+int uthread_set_sched_quantum(unsigned int quantum);
+
+/*
+ * Adaptive time slices
+ *
+ * In adaptive mode, the library keeps track of how long each thread runs on
+ * average before it yields or blocks. A thread that usually stops early, such
+ * as one waiting for I/O, gets time slices twice that long, down to an eighth
+ * of the scheduler's quantum, and preempts a CPU-bound thread of the same or
+ * lower priority when it is woken up. A thread that keeps using up its time
+ * slice gets a slice twice as long each time, up to eight times the
+ * scheduler's quantum, so that it is interrupted less often. A quantum set
+ * with uthread_set_quantum() always takes precedence.
+ */
+
+/*
+ * struct uthread_stats - Scheduling statistics
+ * @runtime: Time spent running, in nanoseconds
+ * @switches: Number of times switched out, voluntarily or not
+ * @preemptions: Number of times preempted
+ * @avg_burst: Average time run before yielding or blocking, in nanoseconds,
+ *	when adaptive time slices are enabled
+ * @quantum: Length of time slices currently used, in microseconds
+ */
+struct uthread_stats {
+	uint64_t runtime;
+	unsigned long switches;
+	unsigned long preemptions;
+	uint64_t avg_burst;
+	unsigned int quantum;
+};
+
+/*
+ * uthread_stats - Get scheduling statistics
+ * @thread: Handle of thread to query, or NULL for all threads since
+ *	uthread_run() was called
+ * @stats: Address where statistics are received
+ *
+ * For all threads, @avg_burst is 0 and @quantum is the scheduler's default.
+ *
+ * Return: -1 if @stats is NULL. 0 if @stats was filled.
+ */
+int uthread_stats(uthread_t thread, struct uthread_stats *stats);
+
+/*
+ * uthread_switch_to - Yield execution to a specific thread
+ * @target: Handle of the thread to run next
+ *
+ * The currently running thread is put back in the ready queue, like with
+ * uthread_yield(), but @target is resumed right away instead of the oldest
+ * ready thread.
+ *
+ * Return: -1 if not called from a thread, if @target is NULL, belongs to
+ * another scheduler, is the currently running thread, or is not ready to run
+ * (e.g., blocked on a semaphore). 0 once the calling thread has been scheduled
+ * again.
+ */
+int uthread_switch_to(uthread_t target);
+
 /*
  * uthread_exit - Exit from currently running thread
  *
@@ -57,4 +307,331 @@ void uthread_yield(void);
  */
 void uthread_exit(void);
 
+/*
+ * Wake-ups from other kernel threads
+ *
+ * The library's functions must only be called by its own threads, with one
+ * exception: uthread_unpark() can be called from any kernel thread, or from a
+ * signal handler, to wake up a thread waiting in uthread_park(). Wake-ups go
+ * through a lock-free inbox, which the scheduler drains at each switch. When
+ * no thread is ready to run, the scheduler's kernel thread sleeps until a
+ * wake-up arrives, and uthread_run() only returns once no thread is parked.
+ */
+
+/*
+ * uthread_park - Wait for a wake-up
+ *
+ * The currently running thread is blocked until uthread_unpark() is called on
+ * it, or returns right away if it was called since the last time the thread
+ * got out of uthread_park(). Several wake-ups before the thread runs again
+ * count as one, so the condition it waits for should be checked again once it
+ * returns.
+ */
+void uthread_park(void);
+
+/*
+ * uthread_unpark - Wake up a thread waiting in uthread_park()
+ * @thread: Handle of thread to wake up
+ *
+ * Can be called from any kernel thread or signal handler. @thread must not have
+ * exited.
+ *
+ * Return: -1 if @thread is NULL. 0 if @thread was woken up, or will not wait
+ * in its next call to uthread_park().
+ */
+int uthread_unpark(uthread_t thread);
+
+/*
+ * Threads from other kernel threads
+ *
+ * Other kernel threads can also request new threads from a scheduler, with
+ * uthread_spawn_remote(). Requests go through another lock-free inbox, and the
+ * scheduler creates the requested threads in a batch at its next switch, or as
+ * soon as it wakes up if it was sleeping. Such a scheduler is created with
+ * uthread_sched_create() and given to uthread_run_config(), which then keeps
+ * waiting for requests after all its threads have finished, until
+ * uthread_sched_stop() is called.
+ */
+
+/*
+ * uthread_sched_create - Create a scheduler
+ *
+ * Can be called from any kernel thread, but not from a thread of the library.
+ *
+ * Return: Handle of the new scheduler, or NULL if called from a thread of the
+ * library or in case of failure
+ */
+uthread_sched_t uthread_sched_create(void);
+
+/*
+ * uthread_sched_destroy - Deallocate a scheduler
+ * @sched: Handle of scheduler to deallocate
+ *
+ * Pending requests are dropped.
+ *
+ * Return: -1 if @sched is NULL or running, 0 otherwise
+ */
+int uthread_sched_destroy(uthread_sched_t sched);
+
+/*
+ * uthread_sched_stop - Let a scheduler return once its threads have finished
+ * @sched: Handle of scheduler to stop
+ *
+ * Can be called from any kernel thread, including the scheduler's own threads.
+ * Requests made before are still honored, later ones are rejected.
+ *
+ * Return: -1 if @sched is NULL, 0 otherwise
+ */
+int uthread_sched_stop(uthread_sched_t sched);
+
+/*
+ * uthread_sched_self - Get the scheduler running the current thread
+ *
+ * Return: Handle of the scheduler, or NULL if not called from a thread of the
+ * library
+ */
+uthread_sched_t uthread_sched_self(void);
+
+/*
+ * uthread_spawn_remote - Request a new thread from a scheduler
+ * @sched: Handle of the scheduler
+ * @func: Function to be executed by the thread
+ * @arg: Argument to be passed to the thread
+ *
+ * Can be called from any kernel thread, including the scheduler's own threads,
+ * but not from a signal handler. The thread gets the default priority and no
+ * group. It is dropped if it can't be created once the scheduler gets to it.
+ *
+ * Return: -1 if @sched or @func is NULL, if @sched was stopped, or in case of
+ * memory allocation failure. 0 if the request was queued.
+ */
+int uthread_spawn_remote(uthread_sched_t sched, uthread_func_t func, void *arg);
+
+/*
+ * Thread priorities
+ *
+ * Priority levels go from UTHREAD_PRIO_HIGHEST (0) to UTHREAD_PRIO_LOWEST, and
+ * a ready thread always runs before the ready threads of lower priority.
+ * Threads start with the priority of the thread that created them, or
+ * UTHREAD_PRIO_DEFAULT for the initial thread.
+ *
+ * This is how the uthread_policy_prio scheduling policy picks the next thread
+ * to run. When preemption is enabled, it behaves as a multi-level feedback
+ * queue: a thread that keeps using its whole time slice temporarily drops a few
+ * levels below the priority it was given, and climbs back up as it blocks
+ * early. Other policies, including the default one, may ignore priorities.
+ */
+#define UTHREAD_PRIO_LEVELS 32
+#define UTHREAD_PRIO_HIGHEST 0
+#define UTHREAD_PRIO_LOWEST (UTHREAD_PRIO_LEVELS - 1)
+#define UTHREAD_PRIO_DEFAULT 16
+
+/*
+ * uthread_setprio - Set priority of a thread
+ * @thread: Handle of thread to modify
+ * @prio: New priority
+ *
+ * Return: -1 if @thread is NULL or if @prio is out of range. 0 if the priority
+ * of @thread was set to @prio.
+ */
+int uthread_setprio(uthread_t thread, int prio);
+
+/*
+ * uthread_getprio - Get priority of a thread
+ * @thread: Handle of thread to query
+ *
+ * Return: -1 if @thread is NULL. Priority given to @thread otherwise.
+ */
+int uthread_getprio(uthread_t thread);
+
+/*
+ * Thread deadlines
+ *
+ * A thread can be given a deadline by which its current piece of work should be
+ * done. The deadline is met if it is cleared or replaced, or if the thread
+ * exits, before it expires; otherwise it is missed. The earliest-deadline-first
+ * policy, uthread_policy_edf, schedules threads according to their deadline,
+ * but deadlines are tracked whatever the policy.
+ */
+
+/*
+ * struct uthread_deadline_stats - Deadline statistics
+ * @met: Number of deadlines met
+ * @missed: Number of deadlines missed
+ * @max_lateness: Longest delay past a deadline, in nanoseconds
+ */
+struct uthread_deadline_stats {
+	unsigned long met;
+	unsigned long missed;
+	uint64_t max_lateness;
+};
+
+/*
+ * uthread_set_deadline - Set deadline of a thread
+ * @thread: Handle of thread to modify
+ * @deadline: Delay from now until the deadline, in nanoseconds, or 0 to clear
+ *	the thread's deadline
+ *
+ * Any previous deadline of @thread is accounted as met or missed.
+ *
+ * Return: -1 if @thread is NULL. 0 if the deadline of @thread was set.
+ */
+int uthread_set_deadline(uthread_t thread, uint64_t deadline);
+
+/*
+ * uthread_create_deadline - Create a new thread with a deadline
+ * @func: Function to be executed by the thread
+ * @arg: Argument to be passed to the thread
+ * @deadline: Delay from now until the thread's deadline, in nanoseconds
+ * @handle: Address where the new thread's handle is received, or NULL
+ *
+ * Return: 0 in case of success, -1 in case of failure (e.g., memory allocation,
+ * context creation).
+ */
+int uthread_create_deadline(uthread_func_t func, void *arg, uint64_t deadline,
+			    uthread_t *handle);
+
+/*
+ * uthread_deadline_stats - Get deadline statistics
+ * @thread: Handle of thread to query, or NULL for all threads since
+ *	uthread_run() was called
+ * @stats: Address where statistics are received
+ *
+ * Return: -1 if @stats is NULL. 0 if @stats was filled.
+ */
+int uthread_deadline_stats(uthread_t thread, struct uthread_deadline_stats *stats);
+
+/*
+ * Stack usage
+ *
+ * When enabled in the configuration, new stacks are filled with a pattern and
+ * each thread's stack is checked for the deepest point it reached when it
+ * exits. Measures are gathered per entry function, i.e. the function the thread
+ * was created with, into a histogram of UTHREAD_STACK_BUCKETS buckets of equal
+ * size covering the whole stack. Threads created with uthread_create_shared()
+ * are not measured.
+ */
+#define UTHREAD_STACK_BUCKETS 8
+
+/*
+ * struct uthread_stack_usage - Stack usage of threads with a same entry function
+ * @func: Entry function of the threads
+ * @threads: Number of threads measured
+ * @max: Largest stack usage, in bytes
+ * @total: Sum of stack usages, in bytes
+ * @histogram: Number of threads per stack usage bucket, from least to most
+ */
+struct uthread_stack_usage {
+	uthread_func_t func;
+	unsigned long threads;
+	size_t max;
+	size_t total;
+	unsigned long histogram[UTHREAD_STACK_BUCKETS];
+};
+
+/*
+ * uthread_stack_usage - Get stack usage measures
+ * @entries: Array receiving one entry per entry function, or NULL
+ * @n: Number of entries that fit in @entries
+ *
+ * Measures are reset each time uthread_run() is called, and remain available
+ * after it returns.
+ *
+ * Return: Total number of entries, which may be more than @n
+ */
+size_t uthread_stack_usage(struct uthread_stack_usage *entries, size_t n);
+
+/*
+ * uthread_stack_report - Print stack usage measures to standard error
+ */
+void uthread_stack_report(void);
+
+/*
+ * UTHREAD_KEYS_MAX - Number of thread-local storage keys
+ *
+ * Each thread holds one inline slot per key, so keys are a scarce resource
+ * shared by the whole process.
+ */
+#define UTHREAD_KEYS_MAX 16
+
+/*
+ * uthread_key_t - Thread-local storage key type
+ */
+typedef unsigned int uthread_key_t;
+
+/*
+ * uthread_key_create - Create a thread-local storage key
+ * @key: Address where the new key is received
+ * @destructor: Function called on a thread's non-NULL value for this key when
+ *	that thread exits, or NULL
+ *
+ * Every thread, including the ones already running, starts with a NULL value
+ * associated to the new key.
+ *
+ * Return: -1 if @key is NULL or if all UTHREAD_KEYS_MAX keys are in use. 0 if
+ * a new key was stored in @key.
+ */
+int uthread_key_create(uthread_key_t *key, void (*destructor)(void *value));
+
+/*
+ * uthread_key_delete - Delete a thread-local storage key
+ * @key: Key to delete
+ *
+ * The destructor associated to @key is not called; releasing the values still
+ * held by threads is up to the caller.
+ *
+ * Return: -1 if @key is not a valid key. 0 if @key was deleted.
+ */
+int uthread_key_delete(uthread_key_t key);
+
+/*
+ * uthread_getspecific - Get the current thread's value for a key
+ * @key: Key to look up
+ *
+ * Return: Value associated to @key by the currently running thread, or NULL if
+ * there is none or if @key is not a valid key.
+ */
+void *uthread_getspecific(uthread_key_t key);
+
+/*
+ * uthread_setspecific - Set the current thread's value for a key
+ * @key: Key to set
+ * @value: Value to associate to @key
+ *
+ * Return: -1 if @key is not a valid key or if called outside of uthread_run().
+ * 0 if @value was associated to @key for the currently running thread.
+ */
+int uthread_setspecific(uthread_key_t key, void *value);
+
+/*
+ * uthread_get_userdata - Get the current thread's user data
+ *
+ * Return: Opaque pointer previously set with uthread_set_userdata(), or NULL
+ */
+void *uthread_get_userdata(void);
+
+/*
+ * uthread_set_userdata - Set the current thread's user data
+ * @data: Opaque pointer to attach to the currently running thread
+ *
+ * Unlike thread-local storage values, user data is never passed to a
+ * destructor.
+ */
+void uthread_set_userdata(void *data);
+
+/*
+ * uthread_alloc - Allocate memory released when the current thread exits
+ * @size: Size in bytes
+ *
+ * Memory comes from an arena of the thread's own, and can't be freed on its
+ * own: the whole arena is released when the thread exits (after its
+ * thread-local storage destructors ran), or when a job run by a pool worker
+ * returns. Allocating is usually a matter of bumping a pointer, and released
+ * memory is kept by the scheduler for its next threads.
+ *
+ * Return: Pointer to memory aligned for any type, or NULL if @size is 0, if
+ * called outside of uthread_run(), or in case of failure when allocating memory
+ */
+void *uthread_alloc(size_t size);
+
 #endif /* _THREAD_H */